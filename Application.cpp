@@ -5,7 +5,9 @@
 #include "classes/Othello.h"
 #include "classes/Connect4.h"
 #include "classes/Chess.h"
-#include "classes/Bitboard.h"   // for BitMove
+#include "classes/bitboard.h"   // for BitMove
+#include "classes/ChessAttacks.h"
+#include <iostream>
 
 namespace ClassGame {
         //
@@ -28,6 +30,10 @@ namespace ClassGame {
             game = nullptr;
             g_lastMoveCount = -1;
             g_moveGenRan    = false;
+
+            // build the chess attack tables once at startup rather than on the first move
+            initChessAttacks();
+            std::cout << "Chess attack tables initialized in " << chessAttacksInitMs() << " ms" << std::endl;
         }
 
         //
@@ -77,12 +83,18 @@ namespace ClassGame {
                     }
                 } else {
                     ImGui::Text("Current Player Number: %d", game->getCurrentPlayer()->playerNumber());
+                    if (game->aiThinking()) {
+                        ImGui::Text("AI thinking...");
+                    }
                     std::string stateString = game->stateString();
                     int stride = game->_gameOptions.rowX;
                     int height = game->_gameOptions.rowY;
 
-                    for (int y = 0; y < height; y++) {
-                        ImGui::Text("%s", stateString.substr(y * stride, stride).c_str());
+                    // one character per square games show as a grid, anything else (chess FEN) only wraps below
+                    if (stateString.size() == (size_t)(stride * height)) {
+                        for (int y = 0; y < height; y++) {
+                            ImGui::Text("%s", stateString.substr(y * stride, stride).c_str());
+                        }
                     }
                     ImGui::TextWrapped("Current Board State: %s", game->stateString().c_str());
 
@@ -101,6 +113,11 @@ namespace ClassGame {
                         (void)moves;
                     }
 
+                    ImGui::Text("Attack tables built in %.2f ms", chessAttacksInitMs());
+                    ImGui::SliderInt("AI Threads", &game->_gameOptions.AIThreads, 1, 8);
+                    ImGui::Checkbox("NNUE evaluation", &game->_gameOptions.AIUseNetwork);
+                    ImGui::Checkbox("Ponder", &game->_gameOptions.AIPonder);
+
                     if (g_moveGenRan) {
                         ImGui::Text("Last move generation: %d moves", g_lastMoveCount);
                         if (g_lastMoveCount == 20) {
@@ -116,10 +133,16 @@ namespace ClassGame {
                 // Game window
                 ImGui::Begin("GameWindow");
                 if (game) {
-                    if (game->gameHasAI() && (game->getCurrentPlayer()->isAIPlayer() || game->_gameOptions.AIvsAI))
+                    bool aiTurn = game->getCurrentPlayer()->isAIPlayer() || game->_gameOptions.AIvsAI;
+                    // nothing is left to search once the game has been decided
+                    if (!gameOver && game->gameHasAI() && aiTurn)
                     {
                         game->updateAI();
                     }
+                    else if (!gameOver && game->gameHasAI() && game->_gameOptions.AIPonder)
+                    {
+                        game->updatePonder();
+                    }
 
                     // Child region that holds the board; dragging here won't move the window
                     ImGui::BeginChild(
@@ -152,5 +175,10 @@ namespace ClassGame {
                 gameOver = true;
                 gameWinner = -1;
             }
+            // a ponder search started on the human's turn would otherwise run on after the end
+            if (gameOver)
+            {
+                game->stopAIWorker();
+            }
         }
 }
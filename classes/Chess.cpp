@@ -2,42 +2,27 @@
 #include <limits>
 #include <cmath>
 #include <cctype>
-#include "Bitboard.h"   // for BitMove + BitboardElement
+#include <filesystem>
+#include <algorithm>
+#include <thread>
+#include "bitboard.h"   // for BitMove + BitboardElement
+#include "ChessAttacks.h"
 #include "../imgui/imgui.h"
 #include <iostream>
-// ===========================================================
-// Knight Move Lookup Table (64 entries)
-// ===========================================================
-static const uint64_t KnightMoves[64] = {
-    0x0000000000020400ULL, 0x0000000000050800ULL, 0x00000000000A1100ULL, 0x0000000000142200ULL,
-    0x0000000000284400ULL, 0x0000000000508800ULL, 0x0000000000A01000ULL, 0x0000000000402000ULL,
-    0x0000000002040004ULL, 0x0000000005080008ULL, 0x000000000A110011ULL, 0x0000000014220022ULL,
-    0x0000000028440044ULL, 0x0000000050880088ULL, 0x00000000A0100010ULL, 0x0000000040200020ULL,
-    0x0000000204000402ULL, 0x0000000508000805ULL, 0x0000000A1100110AULL, 0x0000001422002214ULL,
-    0x0000002844004428ULL, 0x0000005088008850ULL, 0x000000A0100010A0ULL, 0x0000004020002040ULL,
-    0x0000020400040200ULL, 0x0000050800080500ULL, 0x00000A1100110A00ULL, 0x0000142200221400ULL,
-    0x0000284400442800ULL, 0x0000508800885000ULL, 0x0000A0100010A000ULL, 0x0000402000204000ULL,
-    0x0002040004020000ULL, 0x0005080008050000ULL, 0x000A1100110A0000ULL, 0x0014220022140000ULL,
-    0x0028440044280000ULL, 0x0050880088500000ULL, 0x00A0100010A00000ULL, 0x0040200020400000ULL,
-    0x0204000402000000ULL, 0x0508000805000000ULL, 0x0A1100110A000000ULL, 0x1422002214000000ULL,
-    0x2844004428000000ULL, 0x5088008850000000ULL, 0xA0100010A0000000ULL, 0x4020002040000000ULL,
-    0x0400040200000000ULL, 0x0800080500000000ULL, 0x1100110A00000000ULL, 0x2200221400000000ULL,
-    0x4400442800000000ULL, 0x8800885000000000ULL, 0x100010A000000000ULL, 0x2000204000000000ULL,
-    0x0004020000000000ULL, 0x0008050000000000ULL, 0x00110A0000000000ULL, 0x0022140000000000ULL,
-    0x0044280000000000ULL, 0x0088500000000000ULL, 0x0010A00000000000ULL, 0x0020400000000000ULL
-};
-
 // ===========================================================
 // Constructor / Destructor
 // ===========================================================
 
 Chess::Chess()
+    : _promotionPiece(Queen), _tt(16), _search(_tt), _pondering(false)
 {
     _grid = new Grid(8, 8);
+    initChessAttacks();
 }
 
 Chess::~Chess()
 {
+    stopAIWorker();
     delete _grid;
 }
 
@@ -47,57 +32,16 @@ Chess::~Chess()
 
 char Chess::pieceNotation(int x, int y) const
 {
-    const char *wpieces = { "0PNBRQK" };
-    const char *bpieces = { "0pnbrqk" };
-    Bit *bit = _grid->getSquare(x, y)->bit();
-    char notation = '0';
-    if (bit) {
-        notation = bit->gameTag() < 128 ? wpieces[bit->gameTag()] : bpieces[bit->gameTag() - 128];
-    }
-    return notation;
+    return _position.pieceNotation(boardIndex(x, y));
 }
 
-// Convert Bit.gameTag → PieceInfo
-Chess::PieceInfo Chess::getPieceInfo(const Bit& bit) const
-{
-    PieceInfo info{};
-    int tag = bit.gameTag();
-
-    if (tag >= 128) {
-        info.isWhite = false;
-        tag -= 128;
-    } else {
-        info.isWhite = true;
-    }
-
-    switch (tag) {
-        case 1: info.type = PT_Pawn; break;
-        case 2: info.type = PT_Knight; break;
-        case 3: info.type = PT_Bishop; break;
-        case 4: info.type = PT_Rook; break;
-        case 5: info.type = PT_Queen; break;
-        case 6: info.type = PT_King; break;
-        default: info.type = PT_None; break;
-    }
-
-    return info;
-}
-
-// Scan grid to find coordinates of a BitHolder
+// Squares know their own column/row
 bool Chess::getCoordsForHolder(BitHolder& holder, int& xOut, int& yOut)
 {
-    bool found = false;
-    BitHolder* target = &holder;
-
-    _grid->forEachSquare([&](ChessSquare* sq, int x, int y) {
-        if ((BitHolder*)sq == target) {
-            xOut = x;
-            yOut = y;
-            found = true;
-        }
-    });
-
-    return found;
+    ChessSquare* square = static_cast<ChessSquare*>(&holder);
+    xOut = square->getColumn();
+    yOut = square->getRow();
+    return _grid->isValid(xOut, yOut);
 }
 
 // Convert x,y to 0..63 (a1=0, h8=63)
@@ -108,6 +52,11 @@ int Chess::boardIndex(int x, int y) const
     return rank * 8 + file;
 }
 
+ChessSquare* Chess::squareForIndex(int index)
+{
+    return _grid->getSquare(index & 7, 7 - (index >> 3));
+}
+
 
 // ===========================================================
 // FEN Loader
@@ -144,69 +93,71 @@ void Chess::setUpBoard()
     _gameOptions.rowY = 8;
 
     _grid->initializeChessSquares(pieceSize, "boardsquare.png");
-    startGame();
+
+    // AI search: always finish AIDepthSearches plies, never go past AIMAXDepth,
+    // and stop starting new iterations once the time budget is spent
+    _gameOptions.AIDepthSearches = 4;
+    _gameOptions.AIMAXDepth = 64;
+    _gameOptions.AITimeBudgetMs = 2000;
+    // Lazy SMP helpers, one per core up to 8
+    _gameOptions.AIThreads = std::clamp((int)std::thread::hardware_concurrency(), 1, 8);
+    if (!_network.loaded()) {
+        std::string error;
+        if (_network.load("resources/chess.nnue", error))
+            std::cout << "Chess network loaded (" << ChessNetwork::kernelName(ChessNetwork::kernel()) << ")" << std::endl;
+    }
+    if (!_book.isOpen()) {
+        std::string error;
+        if (_book.open("resources/book.bin", error))
+            std::cout << "Chess opening book loaded, " << _book.size() << " entries" << std::endl;
+    }
+    if (!_tablebase.enabled() && std::filesystem::is_directory("resources/tablebases")) {
+        _tablebase.setPath("resources/tablebases");
+        std::cout << "Chess tablebases in resources/tablebases" << std::endl;
+    }
+    _tt.clear();
+
+    if (gameHasAI()) {
+        setAIPlayer(AI_PLAYER);
+    }
 
     // Standard starting position
-    FENtoBoard("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR");
+    FENtoBoard(ChessPosition::StartFEN);
+    startGame();
 }
 
 void Chess::FENtoBoard(const std::string& fen)
 {
-    std::string boardField;
-    size_t sp = fen.find(' ');
-    boardField = (sp == std::string::npos) ? fen : fen.substr(0, sp);
-
-    int slashCount = 0;
-    for (char c : boardField) if (c == '/') ++slashCount;
-    if (slashCount != 7) return;
+    ChessPosition position;
+    if (!position.setFEN(fen)) return;
 
+    _position = position;
+    _history.clear();
     _grid->forEachSquare([](ChessSquare* sq, int, int) { sq->destroyBit(); });
+    syncGridToPosition();
+}
 
-    int x = 0, y = 0;
-
-    auto placePiece = [&](char pch, int file, int rank) {
-        int player = std::isupper((unsigned char) pch) ? 0 : 1;
-        char l = (char) std::tolower((unsigned char)pch);
-
-        ChessPiece piece = NoPiece;
-        switch (l) {
-            case 'p': piece = Pawn;   break;
-            case 'n': piece = Knight; break;
-            case 'b': piece = Bishop; break;
-            case 'r': piece = Rook;   break;
-            case 'q': piece = Queen;  break;
-            case 'k': piece = King;   break;
-            default:  return;
-        }
-
-        ChessSquare* sq = _grid->getSquare(file, rank);
-        if (!sq) return;
-
-        Bit* bit = PieceForPlayer(player, piece);
-        sq->setBit(bit);
+void Chess::syncGridToPosition()
+{
+    _grid->forEachSquare([&](ChessSquare* sq, int x, int y) {
+        int index = boardIndex(x, y);
+        int owner = _position.ownerOn(index);
+        ChessPiece piece = _position.pieceOn(index);
+        int tag = owner < 0 ? 0 : piece + (owner == BLACK ? 128 : 0);
 
-        // IMPORTANT: tie the bit to this square like dropBitAtPoint does
-        bit->setParent(sq);
-        bit->moveTo(sq->getPosition());
-    };
+        Bit* bit = sq->bit();
+        if ((bit ? bit->gameTag() : 0) == tag) return;
 
-    for (char c : boardField)
-    {
-        if (c == '/') {
-            if (x != 8) return;
-            x = 0;
-            y++;
-            continue;
-        }
+        sq->destroyBit();
+        if (tag) {
+            bit = PieceForPlayer(owner, piece);
+            sq->setBit(bit);
 
-        if (std::isdigit((unsigned char)c)) {
-            x += (c - '0');
-            continue;
+            // IMPORTANT: tie the bit to this square like dropBitAtPoint does
+            bit->setParent(sq);
+            bit->moveTo(sq->getPosition());
         }
-
-        placePiece(c, x, y);
-        x++;
-    }
+    });
 }
 
 
@@ -237,204 +188,218 @@ bool Chess::canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst)
     if (!getCoordsForHolder(src, sx, sy)) return false;
     if (!getCoordsForHolder(dst, dx, dy)) return false;
 
-    int dxSigned = dx - sx;
-    int dySigned = dy - sy;
-    int ax = std::abs(dxSigned);
-    int ay = std::abs(dySigned);
+    BitMove move;
+    return findMove(boardIndex(sx, sy), boardIndex(dx, dy), move);
+}
 
-    ChessSquare* dstSq = _grid->getSquare(dx, dy);
-    Bit* dstBit = dstSq ? dstSq->bit() : nullptr;
+// Find the legal move matching a drag.
+// A dragged pawn promotes to _promotionPiece (a queen unless the AI chose otherwise).
+bool Chess::findMove(int from, int to, BitMove& move) const
+{
+    BitMove moves[MAX_CHESS_MOVES];
+    int count = _position.generateLegalMoves(moves);
 
-    PieceInfo info = getPieceInfo(bit);
-    bool isWhite = info.isWhite;
+    for (int i = 0; i < count; i++) {
+        if (moves[i].from != from || moves[i].to != to) continue;
+        if (moves[i].promotion() && moves[i].promotion() != _promotionPiece) continue;
 
-    // Cannot capture own color
-    if (dstBit) {
-        PieceInfo d = getPieceInfo(*dstBit);
-        if (d.isWhite == isWhite)
-            return false;
+        move = moves[i];
+        return true;
     }
+    return false;
+}
 
-    switch (info.type)
-    {
-        case PT_Pawn:
-        {
-            int dir = isWhite ? -1 : 1;
-            int startY = isWhite ? 6 : 1;
-
-            // forward move
-            if (dxSigned == 0)
-            {
-                if (dySigned == dir && !dstBit)
-                    return true;
-
-                if (sy == startY && dySigned == 2 * dir) {
-                    ChessSquare* mid = _grid->getSquare(sx, sy + dir);
-                    if (mid && !mid->bit() && !dstBit)
-                        return true;
-                }
-
-                return false;
-            }
-
-            // diagonal capture
-            if (ax == 1 && dySigned == dir && dstBit)
-                return true;
-
-            return false;
-        }
+void Chess::bitMovedFromTo(Bit &bit, BitHolder &src, BitHolder &dst)
+{
+    int sx, sy, dx, dy;
+    BitMove move;
+    if (getCoordsForHolder(src, sx, sy) && getCoordsForHolder(dst, dx, dy) &&
+        findMove(boardIndex(sx, sy), boardIndex(dx, dy), move)) {
+        PlayedMove played;
+        played.move = move;
+        _position.makeMove(move, played.undo);
+        _history.push_back(played);
+    }
+    // castling, en passant and promotion touch more than the dragged piece
+    syncGridToPosition();
+    endTurn();
+}
 
-        case PT_Knight:
-            return (ax == 1 && ay == 2) || (ax == 2 && ay == 1);
 
-        case PT_King:
-            return (ax <= 1 && ay <= 1 && (ax + ay) != 0);
+void Chess::playMove(const BitMove& move)
+{
+    ChessSquare* src = squareForIndex(move.from);
+    ChessSquare* dst = squareForIndex(move.to);
+    Bit* bit = src ? src->bit() : nullptr;
+    if (!bit || !dst) return;
 
-        default:
-            return false;
+    if (dst->bit()) {
+        pieceTaken(dst->bit());
     }
+    _promotionPiece = move.promotion() ? move.promotion() : (uint8_t)Queen;
+    if (dst->dropBitAtPoint(bit, dst->getPosition())) {
+        src->draggedBitTo(bit, dst);
+        bitMovedFromTo(*bit, *src, *dst);
+    }
+    _promotionPiece = Queen;
 }
 
 
 // ===========================================================
-// Bitboard Occupancy Helpers
+// AI
 // ===========================================================
 
-uint64_t Chess::getOccupancy() const
+// the AI worker hands moves back as an int, packed the same way the transposition table does
+static int packMove(const BitMove &move)
 {
-    uint64_t occ = 0ULL;
-    _grid->forEachSquare([&](ChessSquare* sq, int x, int y) {
-        if (sq->bit()) occ |= (1ULL << boardIndex(x, y));
-    });
-    return occ;
+    return move.from | (move.to << 8) | (move.piece << 16) | (move.flags << 24);
 }
 
-uint64_t Chess::getColorOccupancy(int player) const
+static BitMove unpackMove(int packed)
 {
-    uint64_t occ = 0ULL;
-    _grid->forEachSquare([&](ChessSquare* sq, int x, int y) {
-        Bit* b = sq->bit();
-        if (b && b->getOwner()->playerNumber() == player)
-            occ |= (1ULL << boardIndex(x, y));
-    });
-    return occ;
+    return BitMove(packed & 0xFF, (packed >> 8) & 0xFF, (uint8_t)((packed >> 16) & 0xFF), (uint8_t)((packed >> 24) & 0xFF));
 }
 
+// a ponder search that guessed the human's move just carries on with the clock started,
+// anything else is dropped for a fresh search; the table keeps what it found either way
+void Chess::updateAI()
+{
+    if (_pondering) {
+        _pondering = false;
+        if (aiThinking() && !_history.empty() && _history.back().move == _ponderMove) {
+            _search.ponderHit();
+        } else {
+            stopAIWorker();
+        }
+    }
+    _ponderMove = BitMove();
+    // the worker only gets the limits, the options and search settings are read out here
+    if (!aiThinking()) {
+        _aiLimits = prepareSearch();
+        _aiKeys = gameKeys();
+        _search.prepare();
+    }
+    Game::updateAI();
+}
 
-// ===========================================================
-// Move Generator (Pawn, Knight, King)
-// Returns ~20 moves from starting position
-// ===========================================================
-
-void Chess::generateMovesForCurrentPlayer(BitMove* moves, int& count)
+SearchLimits Chess::prepareSearch()
 {
-    count = 0;
-    int player = getCurrentPlayer()->playerNumber();
+    SearchLimits limits;
+    limits.minDepth = getAIDepathSearches() > 0 ? getAIDepathSearches() : 1;
+    limits.maxDepth = getAIMAXDepth() > 0 ? getAIMAXDepth() : MAX_PLY - 1;
+    limits.softTimeMs = _gameOptions.AITimeBudgetMs;
+    limits.hardTimeMs = _gameOptions.AITimeBudgetMs * 3;
+    if (_search.threads() != _gameOptions.AIThreads) {
+        _search.setThreads(_gameOptions.AIThreads);
+    }
+    _search.setNetwork(_gameOptions.AIUseNetwork && _network.loaded() ? &_network : nullptr);
+    _search.setTablebase(_tablebase.enabled() ? &_tablebase : nullptr, 1, TablebaseLayout::DefaultPieces);
+    return limits;
+}
 
-    uint64_t own = getColorOccupancy(player);
-    (void)own;  // May be used in move generation logic
+// runs on the AI worker thread, _position is only read until applyAIMove() and the search
+// was set up by updateAI()
+int Chess::searchAIMove()
+{
+    BitMove bookMove;
+    if (_book.probe(_position, bookMove)) {
+        return packMove(bookMove);
+    }
 
-    _grid->forEachSquare([&](ChessSquare* sq, int x, int y)
-    {
-        Bit* bit = sq->bit();
-        if (!bit) return;
-        if (bit->getOwner()->playerNumber() != player) return;
-
-        PieceInfo info = getPieceInfo(*bit);
-        int from = boardIndex(x, y);
-
-        // -------------------------------
-        // PAWN MOVES
-        // -------------------------------
-        if (info.type == PT_Pawn)
-        {
-            int dir       = info.isWhite ? -1 : 1;   // white goes "up", black "down"
-            int startRank = info.isWhite ? 6  : 1;   // rank index in your grid
-            int ny        = y + dir;
-
-            // ----- forward 1 -----
-            if (ny >= 0 && ny < 8)
-            {
-                ChessSquare* one = _grid->getSquare(x, ny);
-                if (one && !one->bit())
-                {
-                    moves[count++] = BitMove(from, boardIndex(x, ny), Pawn);
-
-                    // ----- forward 2 from starting rank -----
-                    if (y == startRank) {
-                        int ny2 = y + 2 * dir;
-                        if (ny2 >= 0 && ny2 < 8) {
-                            ChessSquare* mid = _grid->getSquare(x, y + dir);
-                            ChessSquare* two = _grid->getSquare(x, ny2);
-                            if (mid && two && !mid->bit() && !two->bit()) {
-                                moves[count++] = BitMove(from, boardIndex(x, ny2), Pawn);
-                            }
-                        }
-                    }
-                }
-            }
-
-            // ----- capture diagonals -----
-            int left  = x - 1;
-            int right = x + 1;
-
-            if (left >= 0 && ny >= 0 && ny < 8)
-            {
-                ChessSquare* c = _grid->getSquare(left, ny);
-                if (c && c->bit() && c->bit()->getOwner()->playerNumber() != player)
-                    moves[count++] = BitMove(from, boardIndex(left, ny), Pawn);
-            }
-
-            if (right < 8 && ny >= 0 && ny < 8)
-            {
-                ChessSquare* c = _grid->getSquare(right, ny);
-                if (c && c->bit() && c->bit()->getOwner()->playerNumber() != player)
-                    moves[count++] = BitMove(from, boardIndex(right, ny), Pawn);
-            }
-        }
+    BitMove best = _search.search(_position, _aiLimits, _aiKeys);
+    if (best.from == best.to) {
+        return -1; // no legal moves
+    }
+    return packMove(best);
+}
 
+void Chess::applyAIMove(int move)
+{
+    if (move < 0) {
+        return;
+    }
+    BitMove played = unpackMove(move);
+    playMove(played);
+    _ponderMove = expectedReply(played);
+}
 
-        // -------------------------------
-        // KNIGHT MOVES
-        // -------------------------------
-        if (info.type == PT_Knight)
-        {
-            uint64_t attacks = KnightMoves[from] & ~own;
+std::vector<uint64_t> Chess::gameKeys() const
+{
+    std::vector<uint64_t> keys;
+    keys.reserve(_history.size());
+    for (const PlayedMove& played : _history) {
+        keys.push_back(played.undo.key);
+    }
+    return keys;
+}
 
-            BitboardElement bb(attacks);
-            bb.forEachBit([&](int to) {
-                moves[count++] = BitMove(from, to, Knight);
-            });
-        }
+BitMove Chess::expectedReply(const BitMove& played) const
+{
+    const std::vector<BitMove> &pv = _search.lastReport().pv;
+    if (pv.size() > 1 && pv[0] == played) {
+        return pv[1];
+    }
+    // book and tablebase moves come without a line, the table may still know the reply
+    TTData tt;
+    if (_tt.probe(_position.key(), tt)) {
+        return tt.move;
+    }
+    return BitMove();
+}
 
-        // -------------------------------
-        // KING MOVES
-        // -------------------------------
-        if (info.type == PT_King)
-        {
-            uint64_t k = (1ULL << from);
-
-            uint64_t attacks =
-                ((k << 1) & 0xfefefefefefefefeULL) |
-                ((k >> 1) & 0x7f7f7f7f7f7f7f7fULL) |
-                (k << 8) |
-                (k >> 8) |
-                ((k << 9) & 0xfefefefefefefefeULL) |
-                ((k << 7) & 0x7f7f7f7f7f7f7f7fULL) |
-                ((k >> 9) & 0x7f7f7f7f7f7f7f7fULL) |
-                ((k >> 7) & 0xfefefefefefefefeULL);
-
-            attacks &= ~own;
-
-            BitboardElement bb(attacks);
-            bb.forEachBit([&](int to) {
-                moves[count++] = BitMove(from, to, King);
-            });
-        }
+// the human is thinking: search the position after the move they are expected to play.
+// the worker gets its own copy, the human's move changes _position underneath it
+void Chess::updatePonder()
+{
+    if (_pondering || aiThinking() || _ponderMove.from == _ponderMove.to) {
+        return;
+    }
+    // a table move can be a key collision, and the board may have been reloaded since
+    BitMove moves[MAX_CHESS_MOVES];
+    int count = _position.generateLegalMoves(moves);
+    if (std::find(moves, moves + count, _ponderMove) == moves + count) {
+        _ponderMove = BitMove();
+        return;
+    }
 
+    ChessPosition pondered = _position;
+    ChessUndo undo;
+    pondered.makeMove(_ponderMove, undo);
+    _pondering = true;
+    SearchLimits limits = prepareSearch();
+    std::vector<uint64_t> keys = gameKeys();
+    keys.push_back(_position.key());
+    _search.prepare(true);
+    _aiWorker = std::async(std::launch::async, [this, pondered, limits, keys]() {
+        BitMove best = _search.search(pondered, limits, keys);
+        return best.from == best.to ? -1 : packMove(best);
     });
+}
+
+
+// ===========================================================
+// Bitboard Occupancy Helpers
+// ===========================================================
 
-    // Should be exactly 20 moves in starting position
+uint64_t Chess::getOccupancy() const
+{
+    return _position.occupancy();
+}
+
+uint64_t Chess::getColorOccupancy(int player) const
+{
+    return _position.occupancy(player);
+}
+
+
+// ===========================================================
+// Move Generator
+// Returns 20 moves from starting position
+// ===========================================================
+
+void Chess::generateMovesForCurrentPlayer(BitMove* moves, int& count)
+{
+    count = _position.generateLegalMoves(moves);
 }
 
 
@@ -450,14 +415,26 @@ Player* Chess::ownerAt(int x, int y) const
     return sq->bit()->getOwner();
 }
 
+// the side to move has no legal moves and is in check: the player who just moved wins
 Player* Chess::checkForWinner()
 {
-    return nullptr;
+    BitMove moves[MAX_CHESS_MOVES];
+    if (_position.generateLegalMoves(moves) > 0 || !_position.inCheck()) {
+        return nullptr;
+    }
+    return getPlayerAt(_position.sideToMove() ^ 1);
 }
 
+// stalemate, three-fold repetition, the fifty-move rule or too little material to mate.
+// the GUI ends the game on them rather than waiting for a claim
 bool Chess::checkForDraw()
 {
-    return false;
+    BitMove moves[MAX_CHESS_MOVES];
+    if (_position.generateLegalMoves(moves) == 0) {
+        return !_position.inCheck();
+    }
+    std::vector<uint64_t> keys = gameKeys();
+    return _position.isDrawByRule(keys.data(), (int)keys.size(), 2);
 }
 
 
@@ -467,30 +444,33 @@ bool Chess::checkForDraw()
 
 std::string Chess::initialStateString()
 {
-    return stateString();
+    return ChessPosition::StartFEN;
 }
 
+// the chess state is a full FEN, so turns can be logged and reloaded with no other context
 std::string Chess::stateString()
 {
-    std::string s;
-    s.reserve(64);
-    _grid->forEachSquare([&](ChessSquare* sq, int x, int y) {
-        s += pieceNotation(x, y);
-    });
-    return s;
+    return _position.toFEN();
 }
 
 void Chess::setStateString(const std::string &s)
 {
-    _grid->forEachSquare([&](ChessSquare* sq, int x, int y) {
-        char c = s[y * 8 + x];
-        if (c == '0') sq->setBit(nullptr);
-    });
+    stopAIWorker();
+    _pondering = false;
+    FENtoBoard(s);
+    // getCurrentPlayer() goes by turn parity, keep it on the side the FEN says is to move
+    if ((int)(_gameOptions.currentTurnNo & 1) != _position.sideToMove()) {
+        _gameOptions.currentTurnNo++;
+    }
 }
 
 void Chess::stopGame()
 {
+    stopAIWorker();
+    _pondering = false;
+    _ponderMove = BitMove();
     _grid->forEachSquare([](ChessSquare* square, int x, int y) {
         square->destroyBit();
     });
+    _history.clear();
 }
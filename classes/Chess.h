@@ -1,21 +1,16 @@
 #pragma once
-#include "Bitboard.h"
+#include "bitboard.h"
+#include "ChessBook.h"
+#include "ChessNNUE.h"
+#include "ChessPosition.h"
+#include "ChessSearch.h"
+#include "ChessTablebase.h"
+#include "ChessTT.h"
 #include "Game.h"
 #include "Grid.h"
 
 constexpr int pieceSize = 80;
 
-enum ChessPiece
-{
-    NoPiece,
-    Pawn,
-    Knight,
-    Bishop,
-    Rook,
-    Queen,
-    King
-};
-
 class Chess : public Game
 {
 public:
@@ -27,9 +22,18 @@ public:
     bool canBitMoveFrom(Bit &bit, BitHolder &src) override;
     bool canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst) override;
     bool actionForEmptyHolder(BitHolder &holder) override;
+    void bitMovedFromTo(Bit &bit, BitHolder &src, BitHolder &dst) override;
 
     void stopGame() override;
 
+    // AI methods
+    bool gameHasAI() override { return true; }
+    void updateAI() override;
+    int  searchAIMove() override;
+    void applyAIMove(int move) override;
+    void cancelAISearch() override { _search.stop(); }
+    void updatePonder() override;
+
     Player *checkForWinner() override;
     bool checkForDraw() override;
 
@@ -40,23 +44,15 @@ public:
     void setStateString(const std::string &s) override;
 
     Grid* getGrid() override { return _grid; }
+    const ChessPosition& position() const { return _position; }
 
 private:
-    // Internal piece-type enum just for movement logic
-    enum PieceType {
-        PT_None,
-        PT_Pawn,
-        PT_Knight,
-        PT_Bishop,
-        PT_Rook,
-        PT_Queen,
-        PT_King
+    // one entry per move played on the board, newest last
+    struct PlayedMove {
+        BitMove move;
+        ChessUndo undo;
     };
 
-    struct PieceInfo {
-        bool isWhite;
-        PieceType type;
-    };
     uint64_t getOccupancy() const;
     uint64_t getColorOccupancy(int player) const;
     Bit* PieceForPlayer(const int playerNumber, ChessPiece piece);
@@ -65,9 +61,41 @@ private:
     char pieceNotation(int x, int y) const;
 
     // Helpers for movement logic
-    PieceInfo getPieceInfo(const Bit& bit) const;
     bool getCoordsForHolder(BitHolder& holder, int& x, int& y);
     int boardIndex(int x, int y) const;
+    bool findMove(int from, int to, BitMove& move) const;
+    ChessSquare* squareForIndex(int index);
+    // move the sprites through the same holder calls a mouse drag makes
+    void playMove(const BitMove& move);
+    // rebuild any sprites that no longer match _position
+    void syncGridToPosition();
+    // threads, evaluation and tables from the options, then the limits for one AI move.
+    // main thread only, with no search running
+    SearchLimits prepareSearch();
+    // keys of the positions before _position, oldest first, for repetitions
+    std::vector<uint64_t> gameKeys() const;
+    // the reply the search expects after the move just played, null if it has none
+    BitMove expectedReply(const BitMove& played) const;
 
+    // the rules and search work on _position, the grid only mirrors it
+    ChessPosition _position;
+    std::vector<PlayedMove> _history;
+    // piece a pawn turns into when it reaches the last rank
+    uint8_t _promotionPiece;
     Grid* _grid;
+
+    TranspositionTable _tt;
+    ChessSearch _search;
+    // optional network evaluation, read from resources/chess.nnue when the game is set up
+    ChessNetwork _network;
+    // Polyglot opening book, used when resources/book.bin is there
+    ChessBook _book;
+    // endgame tables from tbgen, probed when resources/tablebases is there
+    ChessTablebase _tablebase;
+    // pondering: the human's expected reply, and whether the worker is searching the position after it
+    BitMove _ponderMove;
+    bool _pondering;
+    // limits and game keys for the search searchAIMove() runs, set before the worker starts
+    SearchLimits _aiLimits;
+    std::vector<uint64_t> _aiKeys;
 };
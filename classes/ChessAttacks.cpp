@@ -0,0 +1,217 @@
+#include "ChessAttacks.h"
+#include <chrono>
+
+// ===========================================================
+// Knight Move Lookup Table (64 entries)
+// ===========================================================
+const uint64_t KnightMoves[64] = {
+    0x0000000000020400ULL, 0x0000000000050800ULL, 0x00000000000A1100ULL, 0x0000000000142200ULL,
+    0x0000000000284400ULL, 0x0000000000508800ULL, 0x0000000000A01000ULL, 0x0000000000402000ULL,
+    0x0000000002040004ULL, 0x0000000005080008ULL, 0x000000000A110011ULL, 0x0000000014220022ULL,
+    0x0000000028440044ULL, 0x0000000050880088ULL, 0x00000000A0100010ULL, 0x0000000040200020ULL,
+    0x0000000204000402ULL, 0x0000000508000805ULL, 0x0000000A1100110AULL, 0x0000001422002214ULL,
+    0x0000002844004428ULL, 0x0000005088008850ULL, 0x000000A0100010A0ULL, 0x0000004020002040ULL,
+    0x0000020400040200ULL, 0x0000050800080500ULL, 0x00000A1100110A00ULL, 0x0000142200221400ULL,
+    0x0000284400442800ULL, 0x0000508800885000ULL, 0x0000A0100010A000ULL, 0x0000402000204000ULL,
+    0x0002040004020000ULL, 0x0005080008050000ULL, 0x000A1100110A0000ULL, 0x0014220022140000ULL,
+    0x0028440044280000ULL, 0x0050880088500000ULL, 0x00A0100010A00000ULL, 0x0040200020400000ULL,
+    0x0204000402000000ULL, 0x0508000805000000ULL, 0x0A1100110A000000ULL, 0x1422002214000000ULL,
+    0x2844004428000000ULL, 0x5088008850000000ULL, 0xA0100010A0000000ULL, 0x4020002040000000ULL,
+    0x0400040200000000ULL, 0x0800080500000000ULL, 0x1100110A00000000ULL, 0x2200221400000000ULL,
+    0x4400442800000000ULL, 0x8800885000000000ULL, 0x100010A000000000ULL, 0x2000204000000000ULL,
+    0x0004020000000000ULL, 0x0008050000000000ULL, 0x00110A0000000000ULL, 0x0022140000000000ULL,
+    0x0044280000000000ULL, 0x0088500000000000ULL, 0x0010A00000000000ULL, 0x0020400000000000ULL
+};
+
+uint64_t    KingMoves[64];
+uint64_t    PawnAttacks[2][64];
+SliderMagic BishopMagics[64];
+SliderMagic RookMagics[64];
+uint64_t    BetweenSquares[64][64];
+uint64_t    LineSquares[64][64];
+
+// shared attack storage, sized for the sum of 2^popcount(mask) over all squares
+static uint64_t RookTable[0x19000];
+static uint64_t BishopTable[0x1480];
+
+static bool   s_initialized = false;
+static double s_initMs = 0.0;
+
+static const uint64_t NotFileA = 0xfefefefefefefefeULL;
+static const uint64_t NotFileH = 0x7f7f7f7f7f7f7f7fULL;
+
+// ===========================================================
+// Helpers
+// ===========================================================
+
+static int popCount64(uint64_t bb)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    return (int)__popcnt64(bb);
+#else
+    return __builtin_popcountll(bb);
+#endif
+}
+
+// xorshift64* generator, only used to search for magic multipliers
+class MagicRandom
+{
+public:
+    explicit MagicRandom(uint64_t seed) : _s(seed) { }
+    uint64_t next()
+    {
+        _s ^= _s >> 12;
+        _s ^= _s << 25;
+        _s ^= _s >> 27;
+        return _s * 2685821657736338717ULL;
+    }
+    // magics with few set bits are found much faster
+    uint64_t sparse() { return next() & next() & next(); }
+
+private:
+    uint64_t _s;
+};
+
+// walk the rays one square at a time, only used while building the tables
+static uint64_t slidingAttacks(int square, uint64_t occupancy, const int directions[4][2])
+{
+    uint64_t attacks = 0ULL;
+    int file = square & 7;
+    int rank = square >> 3;
+
+    for (int d = 0; d < 4; d++) {
+        int f = file + directions[d][0];
+        int r = rank + directions[d][1];
+        while (f >= 0 && f < 8 && r >= 0 && r < 8) {
+            uint64_t bit = 1ULL << (r * 8 + f);
+            attacks |= bit;
+            if (occupancy & bit) break;
+            f += directions[d][0];
+            r += directions[d][1];
+        }
+    }
+    return attacks;
+}
+
+static void initSliderMagics(SliderMagic magics[64], uint64_t *table, const int directions[4][2])
+{
+    // seeds per rank that find a full set of magics quickly
+    static const uint64_t seeds[8] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+
+    static uint64_t occupancy[4096];
+    static uint64_t reference[4096];
+    static int      epoch[4096];
+    static int      currentEpoch = 0;
+
+    uint64_t *next = table;
+
+    for (int square = 0; square < 64; square++) {
+        SliderMagic &m = magics[square];
+
+        // the board edges never block a ray, so leave them out of the mask
+        uint64_t rankEdges = (0x00000000000000FFULL | 0xFF00000000000000ULL) & ~(0xFFULL << ((square >> 3) * 8));
+        uint64_t fileEdges = (0x0101010101010101ULL | 0x8080808080808080ULL) & ~(0x0101010101010101ULL << (square & 7));
+        m.mask = slidingAttacks(square, 0ULL, directions) & ~(rankEdges | fileEdges);
+        m.shift = 64 - popCount64(m.mask);
+        m.attacks = next;
+
+        // enumerate every subset of the mask (carry-rippler) with its true attack set
+        int size = 0;
+        uint64_t subset = 0ULL;
+        do {
+            occupancy[size] = subset;
+            reference[size] = slidingAttacks(square, subset, directions);
+#if defined(CHESS_USE_PEXT)
+            m.attacks[_pext_u64(subset, m.mask)] = reference[size];
+#endif
+            size++;
+            subset = (subset - m.mask) & m.mask;
+        } while (subset);
+
+        next += size;
+
+#if !defined(CHESS_USE_PEXT)
+        MagicRandom rng(seeds[square >> 3]);
+        for (int i = 0; i < size;) {
+            do {
+                m.magic = rng.sparse();
+            } while (popCount64((m.magic * m.mask) >> 56) < 6);
+
+            // a magic is good when no two subsets with different attacks share an index
+            ++currentEpoch;
+            for (i = 0; i < size; i++) {
+                unsigned idx = m.index(occupancy[i]);
+                if (epoch[idx] < currentEpoch) {
+                    epoch[idx] = currentEpoch;
+                    m.attacks[idx] = reference[i];
+                } else if (m.attacks[idx] != reference[i]) {
+                    break;
+                }
+            }
+        }
+#else
+        (void)seeds;
+        (void)epoch;
+        (void)currentEpoch;
+#endif
+    }
+}
+
+// ===========================================================
+// Table initialization
+// ===========================================================
+
+void initChessAttacks()
+{
+    if (s_initialized) return;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int square = 0; square < 64; square++) {
+        uint64_t k = 1ULL << square;
+
+        KingMoves[square] =
+            ((k << 1) & NotFileA) |
+            ((k >> 1) & NotFileH) |
+            (k << 8) |
+            (k >> 8) |
+            ((k << 9) & NotFileA) |
+            ((k << 7) & NotFileH) |
+            ((k >> 9) & NotFileH) |
+            ((k >> 7) & NotFileA);
+
+        PawnAttacks[0][square] = ((k << 7) & NotFileH) | ((k << 9) & NotFileA);
+        PawnAttacks[1][square] = ((k >> 9) & NotFileH) | ((k >> 7) & NotFileA);
+    }
+
+    static const int bishopDirections[4][2] = { {1, 1}, {-1, 1}, {1, -1}, {-1, -1} };
+    static const int rookDirections[4][2]   = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
+
+    initSliderMagics(BishopMagics, BishopTable, bishopDirections);
+    initSliderMagics(RookMagics, RookTable, rookDirections);
+
+    // lines through every pair of squares a bishop or rook could connect
+    for (int a = 0; a < 64; a++) {
+        for (int b = 0; b < 64; b++) {
+            BetweenSquares[a][b] = LineSquares[a][b] = 0ULL;
+            if (a == b) continue;
+            uint64_t bBit = 1ULL << b;
+            if (bishopAttacks(a, 0ULL) & bBit) {
+                BetweenSquares[a][b] = bishopAttacks(a, bBit) & bishopAttacks(b, 1ULL << a);
+                LineSquares[a][b] = (bishopAttacks(a, 0ULL) & bishopAttacks(b, 0ULL)) | (1ULL << a) | bBit;
+            } else if (rookAttacks(a, 0ULL) & bBit) {
+                BetweenSquares[a][b] = rookAttacks(a, bBit) & rookAttacks(b, 1ULL << a);
+                LineSquares[a][b] = (rookAttacks(a, 0ULL) & rookAttacks(b, 0ULL)) | (1ULL << a) | bBit;
+            }
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    s_initMs = std::chrono::duration<double, std::milli>(end - start).count();
+    s_initialized = true;
+}
+
+double chessAttacksInitMs()
+{
+    return s_initMs;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#define CHESS_USE_PEXT 1
+#endif
+
+//
+// precomputed attack tables for every piece type
+// squares are numbered a1 = 0 .. h8 = 63, the same as Chess::boardIndex()
+//
+// sliding pieces use "fancy" magic bitboards: the relevant blocker bits of the
+// occupancy are hashed with a per-square multiplier into a dense attack table,
+// so a bishop or rook lookup is a mask, a multiply, a shift and a load.
+// when the compiler targets BMI2 the hash is replaced by a single PEXT.
+//
+
+struct SliderMagic
+{
+    uint64_t  mask;     // relevant blocker squares (edges excluded)
+    uint64_t  magic;    // multiplier, unused with PEXT
+    uint64_t *attacks;  // slice of the shared attack table for this square
+    unsigned  shift;    // 64 - popcount(mask)
+
+    unsigned index(uint64_t occupancy) const
+    {
+#if defined(CHESS_USE_PEXT)
+        return (unsigned)_pext_u64(occupancy, mask);
+#else
+        return (unsigned)(((occupancy & mask) * magic) >> shift);
+#endif
+    }
+};
+
+extern const uint64_t KnightMoves[64];
+extern uint64_t       KingMoves[64];
+extern uint64_t       PawnAttacks[2][64];   // [player 0 = white, 1 = black][square]
+extern SliderMagic    BishopMagics[64];
+extern SliderMagic    RookMagics[64];
+extern uint64_t       BetweenSquares[64][64];   // squares strictly between two aligned squares
+extern uint64_t       LineSquares[64][64];      // the whole rank, file or diagonal through both
+
+// build the tables, safe to call more than once (only the first call does any work)
+void   initChessAttacks();
+// wall clock time the first initChessAttacks() call took. the library prints nothing itself
+// (the uci target's stdout is the protocol stream), the tools and the GUI log this
+double chessAttacksInitMs();
+
+inline uint64_t knightAttacks(int square) { return KnightMoves[square]; }
+inline uint64_t kingAttacks(int square) { return KingMoves[square]; }
+inline uint64_t pawnAttacks(int player, int square) { return PawnAttacks[player][square]; }
+
+inline uint64_t bishopAttacks(int square, uint64_t occupancy)
+{
+    const SliderMagic &m = BishopMagics[square];
+    return m.attacks[m.index(occupancy)];
+}
+
+inline uint64_t rookAttacks(int square, uint64_t occupancy)
+{
+    const SliderMagic &m = RookMagics[square];
+    return m.attacks[m.index(occupancy)];
+}
+
+inline uint64_t queenAttacks(int square, uint64_t occupancy)
+{
+    return bishopAttacks(square, occupancy) | rookAttacks(square, occupancy);
+}
+
+// both are empty when the squares are not on a common rank, file or diagonal
+inline uint64_t betweenSquares(int a, int b) { return BetweenSquares[a][b]; }
+inline uint64_t lineSquares(int a, int b) { return LineSquares[a][b]; }
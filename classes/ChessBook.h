@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "ChessPosition.h"
+#include "MappedFile.h"
+
+// one book move for a position, as stored in the file
+struct BookMove
+{
+    BitMove  move;
+    uint16_t weight;
+};
+
+//
+// Polyglot .bin opening book
+//
+// the file is a sorted array of 16-byte big-endian entries (key, move, weight, learn).
+// it is memory mapped rather than read, so a large book costs no heap and only the
+// pages a lookup touches are ever loaded; a probe is a binary search on the key.
+//
+// Polyglot keys are not our Zobrist keys: they come from the fixed 781-entry Random64
+// table published with Polyglot, which is compiled in.
+//
+class ChessBook
+{
+public:
+    ChessBook();
+
+    // maps the book, closing any book already open. on failure the book is closed
+    // and error says why
+    bool open(const std::string &bookPath, std::string &error);
+    void close();
+    bool isOpen() const { return _file.isOpen(); }
+    size_t size() const { return _file.size() / 16; }
+
+    // the Polyglot hash of a position, no book needed
+    static uint64_t key(const ChessPosition &position);
+
+    // every legal book move for the position, in file order
+    int  movesFor(const ChessPosition &position, std::vector<BookMove> &moves) const;
+    // a book move picked at random in proportion to its weight, false when out of book
+    bool probe(const ChessPosition &position, BitMove &move);
+
+private:
+    uint64_t entryKey(size_t index) const;
+    uint16_t entryMove(size_t index) const;
+    uint16_t entryWeight(size_t index) const;
+    // the legal move a Polyglot move means here, false if there is none
+    bool decodeMove(const ChessPosition &position, uint16_t code, BitMove &move) const;
+
+    MappedFile   _file;
+    std::mt19937 _rng;
+};
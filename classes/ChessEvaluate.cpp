@@ -0,0 +1,197 @@
+#include "ChessEvaluate.h"
+#include <algorithm>
+#include <cstdlib>
+#include "ChessPSQT.h"
+
+const int PieceValue[7] = { 0, 100, 320, 330, 500, 900, 0 };
+
+static const uint64_t FileA = 0x0101010101010101ULL;
+static const uint64_t NotFileA = 0xfefefefefefefefeULL;
+static const uint64_t NotFileH = 0x7f7f7f7f7f7f7f7fULL;
+
+// side to move bonus, the evaluation is never taken in the middle of an exchange
+static const int Tempo = 10;
+
+// per square reachable above a typical count, indexed by ChessPiece
+static const int MobilityMg[7]   = { 0, 0, 4, 3, 2, 1, 0 };
+static const int MobilityEg[7]   = { 0, 0, 4, 3, 4, 2, 0 };
+static const int MobilityBase[7] = { 0, 0, 4, 7, 7, 14, 0 };
+
+static const int BishopPairMg = 30;
+static const int BishopPairEg = 50;
+
+static const int DoubledMg  = -10;
+static const int DoubledEg  = -20;
+static const int IsolatedMg = -10;
+static const int IsolatedEg = -15;
+// by rank counted from the pawn's own side, on top of the piece-square value
+static const int PassedMg[8] = { 0, 5, 10, 15, 25, 45, 70, 0 };
+static const int PassedEg[8] = { 0, 10, 15, 30, 50, 80, 120, 0 };
+// endgame, per square of king distance to the square in front, times the pawn's rank
+static const int PassedEnemyKing = 2;
+static const int PassedOwnKing   = 1;
+
+// ===========================================================
+// Pawn masks
+// ===========================================================
+
+struct PawnMasks
+{
+    uint64_t adjacentFiles[8];
+    uint64_t passed[2][64];     // squares that must hold no enemy pawn for a pawn here to be passed
+};
+
+static constexpr PawnMasks makePawnMasks()
+{
+    PawnMasks masks{};
+    for (int file = 0; file < 8; file++) {
+        masks.adjacentFiles[file] = (file > 0 ? FileA << (file - 1) : 0ULL) | (file < 7 ? FileA << (file + 1) : 0ULL);
+    }
+    for (int square = 0; square < 64; square++) {
+        int file = square & 7;
+        int rank = square >> 3;
+        uint64_t span = (FileA << file) | masks.adjacentFiles[file];
+        uint64_t above = rank < 7 ? ~0ULL << ((rank + 1) * 8) : 0ULL;
+        uint64_t below = rank > 0 ? ~0ULL >> ((8 - rank) * 8) : 0ULL;
+        masks.passed[WHITE][square] = span & above;
+        masks.passed[BLACK][square] = span & below;
+    }
+    return masks;
+}
+
+static constexpr PawnMasks Masks = makePawnMasks();
+
+static uint64_t pawnAttacksOf(int player, uint64_t pawns)
+{
+    if (player == WHITE) return ((pawns << 9) & NotFileA) | ((pawns << 7) & NotFileH);
+    return ((pawns >> 7) & NotFileA) | ((pawns >> 9) & NotFileH);
+}
+
+// ===========================================================
+// Terms, each added from white's side
+// ===========================================================
+
+static void evaluateMobility(const ChessPosition &position, int player, int &mg, int &eg)
+{
+    int sign = player == WHITE ? 1 : -1;
+    uint64_t occ = position.occupancy();
+    // squares the enemy pawns guard are not worth counting
+    uint64_t area = ~position.occupancy(player) & ~pawnAttacksOf(player ^ 1, position.pieces(player ^ 1, Pawn));
+
+    for (int p = Knight; p <= Queen; p++) {
+        uint64_t pieces = position.pieces(player, (ChessPiece)p);
+        while (pieces) {
+            int square = popLsb(pieces);
+            uint64_t attacks;
+            switch (p) {
+                case Knight: attacks = knightAttacks(square); break;
+                case Bishop: attacks = bishopAttacks(square, occ); break;
+                case Rook:   attacks = rookAttacks(square, occ); break;
+                default:     attacks = queenAttacks(square, occ); break;
+            }
+            int count = popCount(attacks & area) - MobilityBase[p];
+            mg += sign * MobilityMg[p] * count;
+            eg += sign * MobilityEg[p] * count;
+        }
+    }
+
+    if (popCount(position.pieces(player, Bishop)) >= 2) {
+        mg += sign * BishopPairMg;
+        eg += sign * BishopPairEg;
+    }
+}
+
+// doubled, isolated and passed pawns: everything that depends on the pawns alone
+void evaluatePawnStructure(const ChessPosition &position, PawnEntry &entry)
+{
+    entry.key = position.pawnKey();
+    int mg = 0, eg = 0;
+
+    for (int player = WHITE; player <= BLACK; player++) {
+        int sign = player == WHITE ? 1 : -1;
+        uint64_t ours = position.pieces(player, Pawn);
+        uint64_t theirs = position.pieces(player ^ 1, Pawn);
+        entry.passed[player] = 0ULL;
+
+        for (int file = 0; file < 8; file++) {
+            int count = popCount(ours & (FileA << file));
+            if (count > 1) {
+                mg += sign * DoubledMg * (count - 1);
+                eg += sign * DoubledEg * (count - 1);
+            }
+        }
+
+        uint64_t pawns = ours;
+        while (pawns) {
+            int square = popLsb(pawns);
+            if (!(ours & Masks.adjacentFiles[square & 7])) {
+                mg += sign * IsolatedMg;
+                eg += sign * IsolatedEg;
+            }
+            if (!(theirs & Masks.passed[player][square])) {
+                int rank = player == WHITE ? square >> 3 : 7 - (square >> 3);
+                mg += sign * PassedMg[rank];
+                eg += sign * PassedEg[rank];
+                entry.passed[player] |= 1ULL << square;
+            }
+        }
+    }
+
+    entry.mg = (int16_t)mg;
+    entry.eg = (int16_t)eg;
+}
+
+static int distance(int a, int b)
+{
+    return std::max(std::abs((a & 7) - (b & 7)), std::abs((a >> 3) - (b >> 3)));
+}
+
+// passed pawns come from the cache, how close the kings are to them does not
+static void evaluatePassedPawns(const ChessPosition &position, const PawnEntry &entry, int &eg)
+{
+    for (int player = WHITE; player <= BLACK; player++) {
+        int sign = player == WHITE ? 1 : -1;
+        int ownKing = position.kingSquare(player);
+        int theirKing = position.kingSquare(player ^ 1);
+        uint64_t passed = entry.passed[player];
+        while (passed) {
+            int square = popLsb(passed);
+            int rank = player == WHITE ? square >> 3 : 7 - (square >> 3);
+            int stop = player == WHITE ? square + 8 : square - 8;
+            eg += sign * (distance(theirKing, stop) * PassedEnemyKing - distance(ownKing, stop) * PassedOwnKing) * rank;
+        }
+    }
+}
+
+// ===========================================================
+// Tapered evaluation
+// ===========================================================
+
+static int evaluateWith(const ChessPosition &position, const PawnEntry &pawns)
+{
+    int mg = position.pieceSquareMg() + pawns.mg;
+    int eg = position.pieceSquareEg() + pawns.eg;
+
+    evaluateMobility(position, WHITE, mg, eg);
+    evaluateMobility(position, BLACK, mg, eg);
+    evaluatePassedPawns(position, pawns, eg);
+
+    int phase = std::min(position.phase(), MaxPhase);
+    int score = (mg * phase + eg * (MaxPhase - phase)) / MaxPhase;
+    return (position.sideToMove() == WHITE ? score : -score) + Tempo;
+}
+
+int evaluate(const ChessPosition &position, ChessPawnTable &pawns)
+{
+    bool hit;
+    PawnEntry &entry = pawns.probe(position.pawnKey(), hit);
+    if (!hit) evaluatePawnStructure(position, entry);
+    return evaluateWith(position, entry);
+}
+
+int evaluate(const ChessPosition &position)
+{
+    PawnEntry entry;
+    evaluatePawnStructure(position, entry);
+    return evaluateWith(position, entry);
+}
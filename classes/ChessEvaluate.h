@@ -0,0 +1,22 @@
+#pragma once
+
+#include "ChessPawnTable.h"
+#include "ChessPosition.h"
+
+// plain centipawn values indexed by ChessPiece, for move ordering and exchange evaluation
+extern const int PieceValue[7];
+
+//
+// hand-written tapered evaluation: every term has a middlegame and an endgame
+// value and the two are blended by the game phase. material and piece-square
+// sums come ready made from the position, mobility and pawn structure are
+// worked out here. pawn structure only depends on the pawns, so it is looked
+// up in a pawn hash when one is given.
+//
+// static evaluation in centipawns from the side to move's point of view
+int evaluate(const ChessPosition &position, ChessPawnTable &pawns);
+// the same without a cache, the pawns are scored every time
+int evaluate(const ChessPosition &position);
+
+// fill in the pawn structure terms and passed pawns of the position, key included
+void evaluatePawnStructure(const ChessPosition &position, PawnEntry &entry);
@@ -0,0 +1,232 @@
+#include "ChessMovePicker.h"
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include "ChessEvaluate.h"
+#include "ChessSEE.h"
+
+// ===========================================================
+// History
+// ===========================================================
+
+void ChessHistory::clear()
+{
+    std::memset(_table, 0, sizeof(_table));
+}
+
+void ChessHistory::age()
+{
+    for (auto &side : _table)
+        for (auto &from : side)
+            for (int &score : from)
+                score /= 2;
+}
+
+void ChessHistory::update(int player, const BitMove &move, int bonus)
+{
+    if (bonus > Limit) bonus = Limit;
+    if (bonus < -Limit) bonus = -Limit;
+    int &score = _table[player][move.from][move.to];
+    score += bonus - score * std::abs(bonus) / Limit;
+}
+
+// ===========================================================
+// Construction
+// ===========================================================
+
+ChessMovePicker::ChessMovePicker(const ChessPosition &position, const BitMove &ttMove, const BitMove killers[2],
+                                 const ChessHistory &history)
+    : _position(position), _history(history), _quiescence(false), _current(0), _end(0), _badCaptures(0)
+{
+    bool inCheck = position.inCheck();
+    _ttMove = position.isLegalMove(ttMove) ? ttMove : BitMove();
+
+    // killers come from sibling nodes, they are only worth a try if they are quiet and legal here
+    for (int i = 0; i < 2; i++) {
+        const BitMove &killer = killers[i];
+        bool usable = !inCheck && !killer.isCapture() && !killer.promotion() && !(killer == _ttMove) &&
+                      !(i == 1 && killer == _killers[0]) && position.isLegalMove(killer);
+        _killers[i] = usable ? killer : BitMove();
+    }
+
+    if (_ttMove.from != _ttMove.to)
+        _stage = StageHashMove;
+    else
+        _stage = inCheck ? StageGenerateEvasions : StageGenerateCaptures;
+}
+
+ChessMovePicker::ChessMovePicker(const ChessPosition &position, const ChessHistory &history)
+    : _position(position), _history(history), _quiescence(true), _current(0), _end(0), _badCaptures(0)
+{
+    _stage = position.inCheck() ? StageGenerateEvasions : StageGenerateCaptures;
+}
+
+// ===========================================================
+// Scoring
+// ===========================================================
+
+// most valuable victim first, least valuable attacker as the tie break
+void ChessMovePicker::scoreCaptures(int begin, int end)
+{
+    for (int i = begin; i < end; i++) {
+        const BitMove &move = _moves[i];
+        ChessPiece victim = (move.flags & BitMove::EnPassant) ? Pawn : _position.pieceOn(move.to);
+        _scores[i] = PieceValue[victim] * 8 + PieceValue[move.promotion()] - move.piece;
+    }
+}
+
+void ChessMovePicker::scoreQuiets(int begin, int end)
+{
+    int us = _position.sideToMove();
+    for (int i = begin; i < end; i++) {
+        _scores[i] = _history.score(us, _moves[i]);
+    }
+}
+
+const BitMove &ChessMovePicker::pickBest()
+{
+    int best = _current;
+    for (int i = _current + 1; i < _end; i++) {
+        if (_scores[i] > _scores[best]) best = i;
+    }
+    if (best != _current) {
+        std::swap(_moves[_current], _moves[best]);
+        std::swap(_scores[_current], _scores[best]);
+    }
+    return _moves[_current];
+}
+
+// a capture is good if the exchange it starts does not lose material.
+// underpromotions are never worth trying early
+bool ChessMovePicker::isGoodCapture(const BitMove &move) const
+{
+    int promotion = move.promotion();
+    if (promotion && promotion != Queen && promotion != Knight) return false;
+
+    // taking something at least as valuable cannot lose, no need to play the exchange out
+    ChessPiece victim = (move.flags & BitMove::EnPassant) ? Pawn : _position.pieceOn(move.to);
+    if (!promotion && PieceValue[victim] >= PieceValue[move.piece]) return true;
+
+    return see(_position, move) >= 0;
+}
+
+bool ChessMovePicker::alreadyTried(const BitMove &move) const
+{
+    return move == _ttMove || move == _killers[0] || move == _killers[1];
+}
+
+// ===========================================================
+// Stages
+// ===========================================================
+
+bool ChessMovePicker::next(BitMove &move)
+{
+    switch (_stage) {
+        case StageHashMove:
+            _stage = _position.inCheck() ? StageGenerateEvasions : StageGenerateCaptures;
+            move = _ttMove;
+            return true;
+
+        case StageGenerateCaptures:
+            _current = 0;
+            _end = _position.generateLegalMoves(_moves, GenCaptures);
+            scoreCaptures(0, _end);
+            _stage = StageGoodCaptures;
+            [[fallthrough]];
+
+        case StageGoodCaptures:
+            while (_current < _end) {
+                BitMove capture = pickBest();
+                _current++;
+                if (capture == _ttMove) continue;
+                // losing captures go back into the slots already handed out, still in order
+                if (!isGoodCapture(capture)) {
+                    _moves[_badCaptures++] = capture;
+                    continue;
+                }
+                move = capture;
+                return true;
+            }
+            // quiescence skips losing captures altogether
+            if (_quiescence) {
+                _stage = StageDone;
+                return false;
+            }
+            _stage = StageKiller1;
+            [[fallthrough]];
+
+        case StageKiller1:
+            _stage = StageKiller2;
+            if (_killers[0].from != _killers[0].to) {
+                move = _killers[0];
+                return true;
+            }
+            [[fallthrough]];
+
+        case StageKiller2:
+            _stage = StageGenerateQuiets;
+            if (_killers[1].from != _killers[1].to) {
+                move = _killers[1];
+                return true;
+            }
+            [[fallthrough]];
+
+        case StageGenerateQuiets:
+            // quiets go after the captures, the bad captures stay at the front
+            _current = _end;
+            _end += _position.generateLegalMoves(_moves + _end, GenQuiets);
+            scoreQuiets(_current, _end);
+            _stage = StageQuiets;
+            [[fallthrough]];
+
+        case StageQuiets:
+            while (_current < _end) {
+                BitMove quiet = pickBest();
+                _current++;
+                if (alreadyTried(quiet)) continue;
+                move = quiet;
+                return true;
+            }
+            _stage = StageBadCaptures;
+            _current = 0;
+            [[fallthrough]];
+
+        case StageBadCaptures:
+            if (_current < _badCaptures) {
+                move = _moves[_current++];
+                return true;
+            }
+            _stage = StageDone;
+            return false;
+
+        case StageGenerateEvasions: {
+            _current = 0;
+            _end = _position.generateLegalMoves(_moves, GenAll);
+            // captures of the checker first, then blocks and king moves by history
+            scoreCaptures(0, _end);
+            int us = _position.sideToMove();
+            for (int i = 0; i < _end; i++) {
+                if (_moves[i].isCapture() || _moves[i].promotion())
+                    _scores[i] += 1 << 20;
+                else
+                    _scores[i] = _history.score(us, _moves[i]);
+            }
+            _stage = StageEvasions;
+            [[fallthrough]];
+        }
+
+        case StageEvasions:
+            while (_current < _end) {
+                BitMove evasion = pickBest();
+                _current++;
+                if (evasion == _ttMove) continue;
+                move = evasion;
+                return true;
+            }
+            _stage = StageDone;
+            return false;
+
+        default:
+            return false;
+    }
+}
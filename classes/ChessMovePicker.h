@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include "ChessPosition.h"
+
+//
+// butterfly history: how often a quiet move from -> to caused a beta cutoff,
+// per side. bonuses are scaled down as the score approaches the limit, so
+// old results fade instead of saturating.
+//
+class ChessHistory
+{
+public:
+    static const int Limit = 16384;
+
+    ChessHistory() { clear(); }
+
+    void clear();
+    // halve every score, done between searches so the table keeps some memory
+    void age();
+    // positive bonus for the cutoff move, negative for the quiets tried before it
+    void update(int player, const BitMove &move, int bonus);
+    int  score(int player, const BitMove &move) const { return _table[player][move.from][move.to]; }
+
+private:
+    int _table[2][64][64];
+};
+
+//
+// hands out the legal moves of a position one at a time, best guess first, and only
+// generates each group when the ones before it have run out:
+//
+//   hash move, good captures (MVV-LVA, SEE >= 0), killer 1, killer 2, quiets (history), bad captures
+//
+// in check every evasion is generated at once and ordered the same way. the quiescence
+// version stops after the good captures.
+//
+class ChessMovePicker
+{
+public:
+    // main search
+    ChessMovePicker(const ChessPosition &position, const BitMove &ttMove, const BitMove killers[2],
+                    const ChessHistory &history);
+    // quiescence search: captures and promotions that do not lose material, or every evasion when in check
+    ChessMovePicker(const ChessPosition &position, const ChessHistory &history);
+
+    // the next move to try, false once every legal move has been returned
+    bool next(BitMove &move);
+
+private:
+    enum Stage
+    {
+        StageHashMove,
+        StageGenerateCaptures,
+        StageGoodCaptures,
+        StageKiller1,
+        StageKiller2,
+        StageGenerateQuiets,
+        StageQuiets,
+        StageBadCaptures,
+        StageGenerateEvasions,
+        StageEvasions,
+        StageDone
+    };
+
+    void scoreCaptures(int begin, int end);
+    void scoreQuiets(int begin, int end);
+    // swap the best scored move in [_current, _end) to the front and return it
+    const BitMove &pickBest();
+    bool isGoodCapture(const BitMove &move) const;
+    bool alreadyTried(const BitMove &move) const;
+
+    const ChessPosition &_position;
+    const ChessHistory  &_history;
+    BitMove              _ttMove;
+    BitMove              _killers[2];
+    bool                 _quiescence;
+    int                  _stage;
+
+    BitMove _moves[MAX_CHESS_MOVES];
+    int     _scores[MAX_CHESS_MOVES];
+    int     _current;
+    int     _end;
+    int     _badCaptures;       // losing captures are parked at the back of _moves
+};
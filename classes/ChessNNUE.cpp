@@ -0,0 +1,491 @@
+#include "ChessNNUE.h"
+#include "ChessSearch.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CHESS_NNUE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC lets any function use the intrinsics
+#define CHESS_NNUE_TARGET_AVX2
+#else
+// only these functions are built for AVX2, the rest of the program runs on any x86-64
+#define CHESS_NNUE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+//
+// network file, little-endian, no padding
+//
+//   char[4]  "GFNN"
+//   uint32   version (1)
+//   uint32   inputs, hidden, l1, l2 (must match the sizes compiled in)
+//   int16    feature bias[hidden]
+//   int16    feature weights[inputs][hidden]
+//   int32    l1 bias[l1],  int8 l1 weights[l1][2 * hidden]
+//   int32    l2 bias[l2],  int8 l2 weights[l2][l1]
+//   int32    output bias,  int8 output weights[l2]
+//
+// activations are clamped to 0..127. the dense layers' sums are shifted down by
+// WeightShift before clamping, and the output sum divided by OutputDivisor is centipawns.
+//
+
+static const char     NetworkMagic[4] = { 'G', 'F', 'N', 'N' };
+static const uint32_t NetworkVersion  = 1;
+static const int      WeightShift     = 6;
+static const int      OutputDivisor   = 16;
+
+// ===========================================================
+// Scalar kernels
+// ===========================================================
+
+static void addColumnScalar(int16_t *values, const int16_t *column)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i++) values[i] += column[i];
+}
+
+static void subColumnScalar(int16_t *values, const int16_t *column)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i++) values[i] -= column[i];
+}
+
+// int16 accumulator values to 0..127 bytes, count a multiple of 32
+static void clippedReLU16Scalar(const int16_t *in, uint8_t *out, int count)
+{
+    for (int i = 0; i < count; i++) out[i] = (uint8_t)std::clamp<int>(in[i], 0, 127);
+}
+
+// out[i] = bias[i] + in . weights[i], inputs a multiple of 32
+static void affineScalar(const uint8_t *in, int inputs, const int8_t *weights, const int32_t *bias,
+                         int32_t *out, int outputs)
+{
+    for (int i = 0; i < outputs; i++) {
+        const int8_t *row = weights + i * inputs;
+        int32_t sum = 0;
+        for (int j = 0; j < inputs; j++) sum += in[j] * row[j];
+        out[i] = bias[i] + sum;
+    }
+}
+
+static void clippedReLU32(const int32_t *in, uint8_t *out, int count)
+{
+    for (int i = 0; i < count; i++) out[i] = (uint8_t)std::clamp(in[i] >> WeightShift, 0, 127);
+}
+
+#if defined(CHESS_NNUE_X86)
+
+// ===========================================================
+// SSE2 kernels, every x86-64 CPU has them
+// ===========================================================
+
+static void addColumnSSE2(int16_t *values, const int16_t *column)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(values + i));
+        __m128i c = _mm_loadu_si128((const __m128i *)(column + i));
+        _mm_storeu_si128((__m128i *)(values + i), _mm_add_epi16(v, c));
+    }
+}
+
+static void subColumnSSE2(int16_t *values, const int16_t *column)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(values + i));
+        __m128i c = _mm_loadu_si128((const __m128i *)(column + i));
+        _mm_storeu_si128((__m128i *)(values + i), _mm_sub_epi16(v, c));
+    }
+}
+
+static void clippedReLU16SSE2(const int16_t *in, uint8_t *out, int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i top = _mm_set1_epi16(127);
+    for (int i = 0; i < count; i += 16) {
+        __m128i a = _mm_min_epi16(_mm_max_epi16(_mm_loadu_si128((const __m128i *)(in + i)), zero), top);
+        __m128i b = _mm_min_epi16(_mm_max_epi16(_mm_loadu_si128((const __m128i *)(in + i + 8)), zero), top);
+        _mm_storeu_si128((__m128i *)(out + i), _mm_packus_epi16(a, b));
+    }
+}
+
+static void affineSSE2(const uint8_t *in, int inputs, const int8_t *weights, const int32_t *bias,
+                       int32_t *out, int outputs)
+{
+    const __m128i zero = _mm_setzero_si128();
+    for (int i = 0; i < outputs; i++) {
+        const int8_t *row = weights + i * inputs;
+        __m128i sum = _mm_setzero_si128();
+        for (int j = 0; j < inputs; j += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i *)(in + j));
+            __m128i b = _mm_loadu_si128((const __m128i *)(row + j));
+            // no byte multiply in SSE2: widen both to int16, the weights with their sign
+            __m128i aLo = _mm_unpacklo_epi8(a, zero);
+            __m128i aHi = _mm_unpackhi_epi8(a, zero);
+            __m128i bLo = _mm_srai_epi16(_mm_unpacklo_epi8(b, b), 8);
+            __m128i bHi = _mm_srai_epi16(_mm_unpackhi_epi8(b, b), 8);
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(aLo, bLo));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(aHi, bHi));
+        }
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+        out[i] = bias[i] + _mm_cvtsi128_si32(sum);
+    }
+}
+
+// ===========================================================
+// AVX2 kernels
+// ===========================================================
+
+CHESS_NNUE_TARGET_AVX2
+static void addColumnAVX2(int16_t *values, const int16_t *column)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(values + i));
+        __m256i c = _mm256_loadu_si256((const __m256i *)(column + i));
+        _mm256_storeu_si256((__m256i *)(values + i), _mm256_add_epi16(v, c));
+    }
+}
+
+CHESS_NNUE_TARGET_AVX2
+static void subColumnAVX2(int16_t *values, const int16_t *column)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(values + i));
+        __m256i c = _mm256_loadu_si256((const __m256i *)(column + i));
+        _mm256_storeu_si256((__m256i *)(values + i), _mm256_sub_epi16(v, c));
+    }
+}
+
+CHESS_NNUE_TARGET_AVX2
+static void clippedReLU16AVX2(const int16_t *in, uint8_t *out, int count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i top = _mm256_set1_epi16(127);
+    for (int i = 0; i < count; i += 32) {
+        __m256i a = _mm256_min_epi16(_mm256_max_epi16(_mm256_loadu_si256((const __m256i *)(in + i)), zero), top);
+        __m256i b = _mm256_min_epi16(_mm256_max_epi16(_mm256_loadu_si256((const __m256i *)(in + i + 16)), zero), top);
+        // packing works within 128-bit lanes, put the quarters back in order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+        _mm256_storeu_si256((__m256i *)(out + i), packed);
+    }
+}
+
+CHESS_NNUE_TARGET_AVX2
+static void affineAVX2(const uint8_t *in, int inputs, const int8_t *weights, const int32_t *bias,
+                       int32_t *out, int outputs)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (int i = 0; i < outputs; i++) {
+        const int8_t *row = weights + i * inputs;
+        __m256i sum = _mm256_setzero_si256();
+        for (int j = 0; j < inputs; j += 32) {
+            __m256i a = _mm256_loadu_si256((const __m256i *)(in + j));
+            __m256i b = _mm256_loadu_si256((const __m256i *)(row + j));
+            // u8 x s8 pairs fit in int16 because activations stop at 127
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(a, b), ones));
+        }
+        __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+        out[i] = bias[i] + _mm_cvtsi128_si32(s);
+    }
+}
+
+#endif
+
+// ===========================================================
+// Kernel selection
+// ===========================================================
+
+struct NNUEKernels
+{
+    ChessNetwork::Kernel kernel;
+    void (*addColumn)(int16_t *values, const int16_t *column);
+    void (*subColumn)(int16_t *values, const int16_t *column);
+    void (*clippedReLU16)(const int16_t *in, uint8_t *out, int count);
+    void (*affine)(const uint8_t *in, int inputs, const int8_t *weights, const int32_t *bias,
+                   int32_t *out, int outputs);
+};
+
+static const NNUEKernels ScalarKernels = {
+    ChessNetwork::KernelScalar, addColumnScalar, subColumnScalar, clippedReLU16Scalar, affineScalar
+};
+#if defined(CHESS_NNUE_X86)
+static const NNUEKernels SSE2Kernels = {
+    ChessNetwork::KernelSSE2, addColumnSSE2, subColumnSSE2, clippedReLU16SSE2, affineSSE2
+};
+static const NNUEKernels AVX2Kernels = {
+    ChessNetwork::KernelAVX2, addColumnAVX2, subColumnAVX2, clippedReLU16AVX2, affineAVX2
+};
+#endif
+
+static bool cpuHasAVX2()
+{
+#if defined(CHESS_NNUE_X86) && defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    // the OS has to save the ymm registers too
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(CHESS_NNUE_X86)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+static ChessNetwork::Kernel defaultKernel()
+{
+#if defined(CHESS_NNUE_X86)
+    static const bool avx2 = cpuHasAVX2();
+    return avx2 ? ChessNetwork::KernelAVX2 : ChessNetwork::KernelSSE2;
+#else
+    return ChessNetwork::KernelScalar;
+#endif
+}
+
+// a constant, so a network used before the selection below still works, on the scalar code
+static const NNUEKernels *Kernels = &ScalarKernels;
+
+// picks the kernels before main(), ahead of any search thread
+static const bool KernelSelected = ChessNetwork::setKernel(defaultKernel());
+
+bool ChessNetwork::kernelSupported(Kernel kernel)
+{
+    if (kernel == KernelScalar) return true;
+#if defined(CHESS_NNUE_X86)
+    if (kernel == KernelSSE2) return true;
+    if (kernel == KernelAVX2) return defaultKernel() == KernelAVX2;
+#endif
+    return false;
+}
+
+bool ChessNetwork::setKernel(Kernel kernel)
+{
+    if (!kernelSupported(kernel)) return false;
+#if defined(CHESS_NNUE_X86)
+    if (kernel == KernelAVX2) {
+        Kernels = &AVX2Kernels;
+        return true;
+    }
+    if (kernel == KernelSSE2) {
+        Kernels = &SSE2Kernels;
+        return true;
+    }
+#endif
+    Kernels = &ScalarKernels;
+    return true;
+}
+
+ChessNetwork::Kernel ChessNetwork::kernel()
+{
+    return Kernels->kernel;
+}
+
+const char *ChessNetwork::kernelName(Kernel kernel)
+{
+    return kernel == KernelAVX2 ? "avx2" : kernel == KernelSSE2 ? "sse2" : "scalar";
+}
+
+// ===========================================================
+// Construction / file io
+// ===========================================================
+
+ChessNetwork::ChessNetwork()
+    : _loaded(false),
+      _ftBias(NNUE_HIDDEN), _ftWeights((size_t)NNUE_INPUTS * NNUE_HIDDEN),
+      _l1Bias(NNUE_L1), _l1Weights((size_t)NNUE_L1 * 2 * NNUE_HIDDEN),
+      _l2Bias(NNUE_L2), _l2Weights((size_t)NNUE_L2 * NNUE_L1),
+      _outBias(0), _outWeights(NNUE_L2)
+{
+}
+
+// reads count values from the file buffer, false if it runs short
+template <typename T>
+static bool readValues(const std::vector<char> &buffer, size_t &offset, T *out, size_t count)
+{
+    size_t bytes = count * sizeof(T);
+    if (offset + bytes > buffer.size()) return false;
+    std::memcpy(out, buffer.data() + offset, bytes);
+    offset += bytes;
+    return true;
+}
+
+template <typename T>
+static void writeValues(std::ofstream &out, const T *values, size_t count)
+{
+    out.write((const char *)values, (std::streamsize)(count * sizeof(T)));
+}
+
+bool ChessNetwork::load(const std::string &path, std::string &error)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::vector<char> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    size_t offset = 0;
+    char magic[4];
+    uint32_t header[5];
+    if (!readValues(buffer, offset, magic, 4) || std::memcmp(magic, NetworkMagic, 4) != 0) {
+        error = path + " is not a network file";
+        return false;
+    }
+    if (!readValues(buffer, offset, header, 5) || header[0] != NetworkVersion) {
+        error = path + " has an unsupported version";
+        return false;
+    }
+    if (header[1] != NNUE_INPUTS || header[2] != NNUE_HIDDEN || header[3] != NNUE_L1 || header[4] != NNUE_L2) {
+        error = path + " has a different architecture";
+        return false;
+    }
+
+    // read into a copy so a bad file leaves the current network alone
+    ChessNetwork network;
+    bool complete = readValues(buffer, offset, network._ftBias.data(), network._ftBias.size()) &&
+                    readValues(buffer, offset, network._ftWeights.data(), network._ftWeights.size()) &&
+                    readValues(buffer, offset, network._l1Bias.data(), network._l1Bias.size()) &&
+                    readValues(buffer, offset, network._l1Weights.data(), network._l1Weights.size()) &&
+                    readValues(buffer, offset, network._l2Bias.data(), network._l2Bias.size()) &&
+                    readValues(buffer, offset, network._l2Weights.data(), network._l2Weights.size()) &&
+                    readValues(buffer, offset, &network._outBias, 1) &&
+                    readValues(buffer, offset, network._outWeights.data(), network._outWeights.size());
+    if (!complete || offset != buffer.size()) {
+        error = path + " has the wrong size";
+        return false;
+    }
+
+    network._loaded = true;
+    *this = std::move(network);
+    return true;
+}
+
+bool ChessNetwork::save(const std::string &path) const
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+
+    uint32_t header[5] = { NetworkVersion, NNUE_INPUTS, NNUE_HIDDEN, NNUE_L1, NNUE_L2 };
+    writeValues(out, NetworkMagic, 4);
+    writeValues(out, header, 5);
+    writeValues(out, _ftBias.data(), _ftBias.size());
+    writeValues(out, _ftWeights.data(), _ftWeights.size());
+    writeValues(out, _l1Bias.data(), _l1Bias.size());
+    writeValues(out, _l1Weights.data(), _l1Weights.size());
+    writeValues(out, _l2Bias.data(), _l2Bias.size());
+    writeValues(out, _l2Weights.data(), _l2Weights.size());
+    writeValues(out, &_outBias, 1);
+    writeValues(out, _outWeights.data(), _outWeights.size());
+    return (bool)out;
+}
+
+void ChessNetwork::randomize(uint64_t seed)
+{
+    uint64_t state = seed;
+    // splitmix64, values in [-range, range]
+    auto next = [&state](int range) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        return (int)(z % (uint64_t)(2 * range + 1)) - range;
+    };
+
+    for (int16_t &w : _ftBias) w = (int16_t)(32 + next(16));
+    for (int16_t &w : _ftWeights) w = (int16_t)next(12);
+    for (int32_t &w : _l1Bias) w = next(256);
+    for (int8_t &w : _l1Weights) w = (int8_t)next(4);
+    for (int32_t &w : _l2Bias) w = next(256);
+    for (int8_t &w : _l2Weights) w = (int8_t)next(16);
+    _outBias = 0;
+    for (int8_t &w : _outWeights) w = (int8_t)next(16);
+    _loaded = true;
+}
+
+// ===========================================================
+// Accumulator
+// ===========================================================
+
+// each side sees the board as if it were white: its own pieces first, ranks flipped for black
+int ChessNetwork::featureIndex(int perspective, int player, int piece, int square)
+{
+    int relative = perspective == WHITE ? square : square ^ 56;
+    return ((player == perspective ? 0 : 6) + piece - 1) * 64 + relative;
+}
+
+void ChessNetwork::refresh(const ChessPosition &position, NNUEAccumulator &accumulator) const
+{
+    for (int perspective = WHITE; perspective <= BLACK; perspective++) {
+        int16_t *values = accumulator.values[perspective];
+        std::memcpy(values, _ftBias.data(), sizeof(int16_t) * NNUE_HIDDEN);
+        for (int player = WHITE; player <= BLACK; player++) {
+            for (int piece = Pawn; piece <= King; piece++) {
+                uint64_t bb = position.pieces(player, (ChessPiece)piece);
+                while (bb) {
+                    int feature = featureIndex(perspective, player, piece, popLsb(bb));
+                    Kernels->addColumn(values, &_ftWeights[(size_t)feature * NNUE_HIDDEN]);
+                }
+            }
+        }
+    }
+    accumulator.computed = true;
+}
+
+void ChessNetwork::update(const NNUEAccumulator &parent, NNUEAccumulator &child) const
+{
+    for (int perspective = WHITE; perspective <= BLACK; perspective++) {
+        int16_t *values = child.values[perspective];
+        std::memcpy(values, parent.values[perspective], sizeof(int16_t) * NNUE_HIDDEN);
+        for (int i = 0; i < child.dirtyCount; i++) {
+            const DirtyPiece &dirty = child.dirty[i];
+            if (dirty.from >= 0) {
+                int feature = featureIndex(perspective, dirty.player, dirty.piece, dirty.from);
+                Kernels->subColumn(values, &_ftWeights[(size_t)feature * NNUE_HIDDEN]);
+            }
+            if (dirty.to >= 0) {
+                int feature = featureIndex(perspective, dirty.player, dirty.piece, dirty.to);
+                Kernels->addColumn(values, &_ftWeights[(size_t)feature * NNUE_HIDDEN]);
+            }
+        }
+    }
+    child.computed = true;
+}
+
+// ===========================================================
+// Forward pass
+// ===========================================================
+
+int ChessNetwork::evaluate(const ChessPosition &position, const NNUEAccumulator &accumulator) const
+{
+    alignas(32) uint8_t input[2 * NNUE_HIDDEN];
+    alignas(32) int32_t l1[NNUE_L1];
+    alignas(32) uint8_t l1Out[NNUE_L1];
+    alignas(32) int32_t l2[NNUE_L2];
+    alignas(32) uint8_t l2Out[NNUE_L2];
+
+    // side to move's half first, so the same weights work for both colours
+    int us = position.sideToMove();
+    Kernels->clippedReLU16(accumulator.values[us], input, NNUE_HIDDEN);
+    Kernels->clippedReLU16(accumulator.values[us ^ 1], input + NNUE_HIDDEN, NNUE_HIDDEN);
+
+    Kernels->affine(input, 2 * NNUE_HIDDEN, _l1Weights.data(), _l1Bias.data(), l1, NNUE_L1);
+    clippedReLU32(l1, l1Out, NNUE_L1);
+    Kernels->affine(l1Out, NNUE_L1, _l2Weights.data(), _l2Bias.data(), l2, NNUE_L2);
+    clippedReLU32(l2, l2Out, NNUE_L2);
+
+    int32_t output;
+    Kernels->affine(l2Out, NNUE_L2, _outWeights.data(), &_outBias, &output, 1);
+    // any EvalFile loads, so keep even a wild output below the decided scores the search adjusts
+    static const int Bound = SCORE_TB_WIN - MAX_PLY - 1;
+    return std::clamp(output / OutputDivisor, -Bound, Bound);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ChessPosition.h"
+
+//
+// efficiently updatable neural network (NNUE) evaluation, an alternative to evaluate()
+//
+//   768 inputs (colour x piece x square, seen from each side) -> 256 int16 per side
+//   -> clipped ReLU -> 32 -> clipped ReLU -> 32 -> clipped ReLU -> 1
+//
+// the first layer is an accumulator: a move changes at most three inputs, so the
+// search adds and subtracts a few weight columns instead of recomputing it. the
+// dense layers after it are int8. the kernels go through pointers picked at startup:
+// AVX2 where the CPU has it, SSE2 on any other x86-64, plain C++ elsewhere.
+//
+const int NNUE_INPUTS = 768;
+const int NNUE_HIDDEN = 256;
+const int NNUE_L1     = 32;
+const int NNUE_L2     = 32;
+
+// first layer output for both perspectives, the search keeps one per ply
+struct NNUEAccumulator
+{
+    alignas(32) int16_t values[2][NNUE_HIDDEN];
+    bool       computed;    // false until brought up to date from the ply before
+    uint8_t    dirtyCount;
+    DirtyPiece dirty[3];    // the move that led here, copied from ChessUndo
+};
+
+class ChessNetwork
+{
+public:
+    ChessNetwork();
+
+    // reads a network file (layout in ChessNNUE.cpp). on failure the network is
+    // left as it was and error says why
+    bool load(const std::string &path, std::string &error);
+    bool save(const std::string &path) const;
+    // small deterministic random weights, only good for exercising and timing the code
+    void randomize(uint64_t seed);
+    bool loaded() const { return _loaded; }
+
+    // the accumulator from scratch
+    void refresh(const ChessPosition &position, NNUEAccumulator &accumulator) const;
+    // the child from its parent and the pieces its move changed
+    void update(const NNUEAccumulator &parent, NNUEAccumulator &child) const;
+    // centipawns from the side to move's point of view, the accumulator must be up to date.
+    // clamped below every tablebase and mate score
+    int  evaluate(const ChessPosition &position, const NNUEAccumulator &accumulator) const;
+
+    // every kernel gives the same results, bit for bit
+    enum Kernel { KernelScalar, KernelSSE2, KernelAVX2 };
+    static bool kernelSupported(Kernel kernel);
+    // switches the kernels for every network, meant for benchmarks. false if the CPU cannot run it
+    static bool setKernel(Kernel kernel);
+    static Kernel kernel();
+    // "avx2", "sse2" or "scalar"
+    static const char *kernelName(Kernel kernel);
+
+private:
+    static int featureIndex(int perspective, int player, int piece, int square);
+
+    bool _loaded;
+
+    std::vector<int16_t> _ftBias;       // [hidden]
+    std::vector<int16_t> _ftWeights;    // [inputs][hidden], one column per input
+    std::vector<int32_t> _l1Bias;       // [l1]
+    std::vector<int8_t>  _l1Weights;    // [l1][2 * hidden]
+    std::vector<int32_t> _l2Bias;       // [l2]
+    std::vector<int8_t>  _l2Weights;    // [l2][l1]
+    int32_t              _outBias;
+    std::vector<int8_t>  _outWeights;   // [l2]
+};
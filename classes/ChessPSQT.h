@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+//
+// material plus piece-square bonuses, one middlegame and one endgame value per
+// piece and square. indexed like ChessPosition's bitboards, [player * 6 + piece - 1][square],
+// and signed from white's point of view so a position can keep a running sum.
+//
+struct PieceSquareTables
+{
+    int16_t mg[12][64];
+    int16_t eg[12][64];
+};
+
+extern const PieceSquareTables PSQT;
+
+// game phase: 24 with all the pieces on the board, 0 with only kings and pawns left
+constexpr int PhaseWeight[7] = { 0, 0, 1, 1, 2, 4, 0 };   // indexed by ChessPiece
+constexpr int MaxPhase = 24;
+
+// material alone, indexed by ChessPiece
+constexpr int MaterialMg[7] = { 0, 82, 337, 365, 477, 1025, 0 };
+constexpr int MaterialEg[7] = { 0, 94, 281, 297, 512, 936, 0 };
@@ -0,0 +1,23 @@
+#include "ChessPawnTable.h"
+
+ChessPawnTable::ChessPawnTable(int bits)
+    : _entries((size_t)1 << bits), _mask(((uint64_t)1 << bits) - 1), _hits(0), _probes(0)
+{
+    clear();
+}
+
+void ChessPawnTable::clear()
+{
+    // a zeroed entry has key 0, the key of a board with no pawns, and scores it correctly
+    for (PawnEntry &entry : _entries) entry = PawnEntry{ 0, { 0, 0 }, 0, 0 };
+    resetStats();
+}
+
+PawnEntry &ChessPawnTable::probe(uint64_t key, bool &hit)
+{
+    PawnEntry &entry = _entries[key & _mask];
+    _probes++;
+    hit = entry.key == key;
+    if (hit) _hits++;
+    return entry;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// pawn structure terms for one pawn skeleton, from white's side
+struct PawnEntry
+{
+    uint64_t key;
+    uint64_t passed[2];     // passed pawns per player, for the terms that also depend on the kings
+    int16_t  mg;
+    int16_t  eg;
+};
+
+//
+// cache of pawn structure scores keyed on ChessPosition::pawnKey()
+//
+// the pawns change on few moves, so nearly every evaluation finds its skeleton
+// already scored here. each search thread has its own table, there is no locking.
+//
+class ChessPawnTable
+{
+public:
+    explicit ChessPawnTable(int bits = 14);
+
+    void clear();
+    // the slot for this key. when hit comes back false the caller scores the
+    // pawns and fills the entry in, key included
+    PawnEntry &probe(uint64_t key, bool &hit);
+
+    // profiling counters, kept until resetStats()
+    uint64_t hits() const { return _hits; }
+    uint64_t probes() const { return _probes; }
+    void     resetStats() { _hits = _probes = 0; }
+
+private:
+    std::vector<PawnEntry> _entries;
+    uint64_t               _mask;
+    uint64_t               _hits;
+    uint64_t               _probes;
+};
@@ -0,0 +1,63 @@
+#include "ChessPerft.h"
+
+// ===========================================================
+// Perft
+// ===========================================================
+
+uint64_t perft(ChessPosition &position, int depth)
+{
+    if (depth == 0) return 1;
+
+    BitMove moves[MAX_CHESS_MOVES];
+    int count = position.generateLegalMoves(moves);
+    // every move is legal, so the last ply is just the count
+    if (depth == 1) return (uint64_t)count;
+
+    uint64_t nodes = 0;
+    for (int i = 0; i < count; i++) {
+        ChessUndo undo;
+        position.makeMove(moves[i], undo);
+        nodes += perft(position, depth - 1);
+        position.unmakeMove(moves[i], undo);
+    }
+    return nodes;
+}
+
+uint64_t perftPseudoLegal(ChessPosition &position, int depth)
+{
+    if (depth == 0) return 1;
+
+    BitMove moves[MAX_CHESS_MOVES];
+    int count = position.generateMoves(moves);
+    int us = position.sideToMove();
+    uint64_t nodes = 0;
+
+    for (int i = 0; i < count; i++) {
+        ChessUndo undo;
+        position.makeMove(moves[i], undo);
+        if (!position.isSquareAttacked(position.kingSquare(us), us ^ 1)) {
+            nodes += depth == 1 ? 1 : perftPseudoLegal(position, depth - 1);
+        }
+        position.unmakeMove(moves[i], undo);
+    }
+    return nodes;
+}
+
+uint64_t perftDivide(ChessPosition &position, int depth, std::ostream &out)
+{
+    if (depth <= 0) return 1;
+
+    BitMove moves[MAX_CHESS_MOVES];
+    int count = position.generateLegalMoves(moves);
+    uint64_t total = 0;
+
+    for (int i = 0; i < count; i++) {
+        ChessUndo undo;
+        position.makeMove(moves[i], undo);
+        uint64_t nodes = perft(position, depth - 1);
+        out << moveToString(moves[i]) << ": " << nodes << "\n";
+        total += nodes;
+        position.unmakeMove(moves[i], undo);
+    }
+    return total;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include "ChessPosition.h"
+
+//
+// perft: count the leaf nodes of the legal move tree to a fixed depth.
+// the counts for well known positions are published, so any difference
+// points straight at a move generator (or make/unmake) bug.
+//
+
+uint64_t perft(ChessPosition &position, int depth);
+
+// the same count from pseudo-legal moves filtered by make/test/unmake,
+// kept as an independent reference for the legal generator
+uint64_t perftPseudoLegal(ChessPosition &position, int depth);
+
+// perft split by root move, one "e2e4: 12345" line per move, returns the total
+uint64_t perftDivide(ChessPosition &position, int depth, std::ostream &out);
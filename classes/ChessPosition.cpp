@@ -0,0 +1,778 @@
+#include "ChessPosition.h"
+#include "ChessPSQT.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <sstream>
+
+const char *ChessPosition::StartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+static const uint64_t Rank1 = 0x00000000000000FFULL;
+static const uint64_t Rank3 = 0x0000000000FF0000ULL;
+static const uint64_t Rank6 = 0x0000FF0000000000ULL;
+static const uint64_t Rank8 = 0xFF00000000000000ULL;
+
+// castling rights that survive a move touching each square (a1, e1, h1, a8, e8, h8 clear rights)
+static const uint8_t CastlingMask[64] = {
+    13, 15, 15, 15, 12, 15, 15, 14,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+     7, 15, 15, 15,  3, 15, 15, 11
+};
+
+std::string moveToString(const BitMove &move)
+{
+    std::string s;
+    s += (char)('a' + (move.from & 7));
+    s += (char)('1' + (move.from >> 3));
+    s += (char)('a' + (move.to & 7));
+    s += (char)('1' + (move.to >> 3));
+    if (move.promotion()) s += "0pnbrqk"[move.promotion()];
+    return s;
+}
+
+// ===========================================================
+// Zobrist keys
+// ===========================================================
+
+struct ZobristKeys
+{
+    uint64_t pieces[12][64];
+    uint64_t castling[16];
+    uint64_t epFile[8];
+    uint64_t side;
+};
+
+// splitmix64 with a fixed seed so keys are identical on every run and build
+static constexpr ZobristKeys makeZobristKeys()
+{
+    ZobristKeys keys{};
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    auto next = [&state]() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    };
+    for (auto &piece : keys.pieces)
+        for (auto &square : piece)
+            square = next();
+    for (auto &castling : keys.castling) castling = next();
+    for (auto &file : keys.epFile) file = next();
+    keys.side = next();
+    return keys;
+}
+
+static constexpr ZobristKeys Zobrist = makeZobristKeys();
+
+// ===========================================================
+// Setup
+// ===========================================================
+
+void ChessPosition::clear()
+{
+    std::memset(_pieces, 0, sizeof(_pieces));
+    _occupancy[WHITE] = _occupancy[BLACK] = 0ULL;
+    // the key of an empty board with no castling rights, so putPiece() on a cleared board
+    // arrives at the same key as computeKey()
+    _key = Zobrist.castling[0];
+    _pawnKey = 0ULL;
+    _sideToMove = WHITE;
+    _castling = 0;
+    _epSquare = -1;
+    _halfmoveClock = 0;
+    _fullmoveNumber = 1;
+    _psqMg = _psqEg = 0;
+    _phase = 0;
+}
+
+bool ChessPosition::setFEN(const std::string &fen)
+{
+    std::istringstream in(fen);
+    std::string placement, side, castling, ep;
+    int halfmove = 0, fullmove = 1;
+    in >> placement >> side >> castling >> ep;
+    // the clocks are optional, EPD lines stop after the en passant field
+    if (!(in >> halfmove)) halfmove = 0;
+    if (!(in >> fullmove)) fullmove = 1;
+
+    clear();
+
+    int file = 0, rank = 7;
+    for (char c : placement) {
+        if (c == '/') {
+            if (file != 8 || rank == 0) return false;
+            file = 0;
+            rank--;
+            continue;
+        }
+        if (std::isdigit((unsigned char)c)) {
+            file += c - '0';
+            if (file > 8) return false;
+            continue;
+        }
+
+        int player = std::isupper((unsigned char)c) ? WHITE : BLACK;
+        ChessPiece piece = NoPiece;
+        switch (std::tolower((unsigned char)c)) {
+            case 'p': piece = Pawn;   break;
+            case 'n': piece = Knight; break;
+            case 'b': piece = Bishop; break;
+            case 'r': piece = Rook;   break;
+            case 'q': piece = Queen;  break;
+            case 'k': piece = King;   break;
+            default:  return false;
+        }
+        if (file > 7) return false;
+        putPiece(player, piece, rank * 8 + file);
+        file++;
+    }
+    if (rank != 0 || file != 8) return false;
+    if (popCount(pieces(WHITE, King)) != 1 || popCount(pieces(BLACK, King)) != 1) return false;
+
+    if (side == "b") _sideToMove = BLACK;
+    else if (side.empty() || side == "w") _sideToMove = WHITE;
+    else return false;
+
+    for (char c : castling) {
+        switch (c) {
+            case 'K': _castling |= WhiteKingside;  break;
+            case 'Q': _castling |= WhiteQueenside; break;
+            case 'k': _castling |= BlackKingside;  break;
+            case 'q': _castling |= BlackQueenside; break;
+            default: break;
+        }
+    }
+    // drop rights the pieces no longer back up, makeMove() relies on king and rook being home
+    if (!(pieces(WHITE, King) & (1ULL << 4)))  _castling &= ~(WhiteKingside | WhiteQueenside);
+    if (!(pieces(BLACK, King) & (1ULL << 60))) _castling &= ~(BlackKingside | BlackQueenside);
+    if (!(pieces(WHITE, Rook) & (1ULL << 7)))  _castling &= ~WhiteKingside;
+    if (!(pieces(WHITE, Rook) & (1ULL << 0)))  _castling &= ~WhiteQueenside;
+    if (!(pieces(BLACK, Rook) & (1ULL << 63))) _castling &= ~BlackKingside;
+    if (!(pieces(BLACK, Rook) & (1ULL << 56))) _castling &= ~BlackQueenside;
+
+    // the target must be behind a pawn of the side that just moved, and kept only when a pawn
+    // can take on it, as makeMove() does
+    if (ep.size() == 2 && ep[0] >= 'a' && ep[0] <= 'h' && ep[1] == (_sideToMove == WHITE ? '6' : '3')) {
+        int square = (ep[1] - '1') * 8 + (ep[0] - 'a');
+        if (pawnAttacks(_sideToMove ^ 1, square) & pieces(_sideToMove, Pawn)) _epSquare = (int8_t)square;
+    }
+
+    _halfmoveClock = (uint8_t)std::clamp(halfmove, 0, 255);
+    _fullmoveNumber = (uint16_t)std::clamp(fullmove, 1, 65535);
+
+    _key = computeKey();
+    _pawnKey = computePawnKey();
+    return true;
+}
+
+std::string ChessPosition::toFEN() const
+{
+    std::string fen;
+    fen.reserve(90);
+
+    for (int rank = 7; rank >= 0; rank--) {
+        int empty = 0;
+        for (int file = 0; file < 8; file++) {
+            char c = pieceNotation(rank * 8 + file);
+            if (c == '0') {
+                empty++;
+                continue;
+            }
+            if (empty) fen += (char)('0' + empty);
+            empty = 0;
+            fen += c;
+        }
+        if (empty) fen += (char)('0' + empty);
+        if (rank) fen += '/';
+    }
+
+    fen += _sideToMove == WHITE ? " w " : " b ";
+
+    if (_castling & WhiteKingside)  fen += 'K';
+    if (_castling & WhiteQueenside) fen += 'Q';
+    if (_castling & BlackKingside)  fen += 'k';
+    if (_castling & BlackQueenside) fen += 'q';
+    if (!_castling) fen += '-';
+
+    fen += ' ';
+    if (_epSquare >= 0) {
+        fen += (char)('a' + (_epSquare & 7));
+        fen += (char)('1' + (_epSquare >> 3));
+    } else {
+        fen += '-';
+    }
+
+    fen += ' ';
+    fen += std::to_string(_halfmoveClock);
+    fen += ' ';
+    fen += std::to_string(_fullmoveNumber);
+    return fen;
+}
+
+uint64_t ChessPosition::computeKey() const
+{
+    uint64_t key = 0ULL;
+    for (int i = 0; i < 12; i++) {
+        uint64_t bb = _pieces[i];
+        while (bb) key ^= Zobrist.pieces[i][popLsb(bb)];
+    }
+    key ^= Zobrist.castling[_castling];
+    if (_epSquare >= 0) key ^= Zobrist.epFile[_epSquare & 7];
+    if (_sideToMove == BLACK) key ^= Zobrist.side;
+    return key;
+}
+
+uint64_t ChessPosition::computePawnKey() const
+{
+    uint64_t key = 0ULL;
+    for (int player = WHITE; player <= BLACK; player++) {
+        int index = pieceIndex(player, Pawn);
+        uint64_t bb = _pieces[index];
+        while (bb) key ^= Zobrist.pieces[index][popLsb(bb)];
+    }
+    return key;
+}
+
+void ChessPosition::computePieceSquare(int &mg, int &eg, int &phase) const
+{
+    mg = eg = phase = 0;
+    for (int i = 0; i < 12; i++) {
+        uint64_t bb = _pieces[i];
+        while (bb) {
+            int square = popLsb(bb);
+            mg += PSQT.mg[i][square];
+            eg += PSQT.eg[i][square];
+            phase += PhaseWeight[i % 6 + 1];
+        }
+    }
+}
+
+void ChessPosition::putPiece(int player, ChessPiece piece, int square)
+{
+    uint64_t bit = 1ULL << square;
+    int index = pieceIndex(player, piece);
+    _pieces[index] |= bit;
+    _occupancy[player] |= bit;
+    _key ^= Zobrist.pieces[index][square];
+    if (piece == Pawn) _pawnKey ^= Zobrist.pieces[index][square];
+    _psqMg += PSQT.mg[index][square];
+    _psqEg += PSQT.eg[index][square];
+    _phase += PhaseWeight[piece];
+}
+
+void ChessPosition::setSideToMove(int player)
+{
+    if (player == _sideToMove) return;
+    _sideToMove = (uint8_t)player;
+    _key ^= Zobrist.side;
+}
+
+void ChessPosition::removePiece(int player, ChessPiece piece, int square)
+{
+    uint64_t bit = 1ULL << square;
+    int index = pieceIndex(player, piece);
+    _pieces[index] &= ~bit;
+    _occupancy[player] &= ~bit;
+    _key ^= Zobrist.pieces[index][square];
+    if (piece == Pawn) _pawnKey ^= Zobrist.pieces[index][square];
+    _psqMg -= PSQT.mg[index][square];
+    _psqEg -= PSQT.eg[index][square];
+    _phase -= PhaseWeight[piece];
+}
+
+// ===========================================================
+// Piece queries
+// ===========================================================
+
+int ChessPosition::ownerOn(int square) const
+{
+    uint64_t bit = 1ULL << square;
+    if (_occupancy[WHITE] & bit) return WHITE;
+    if (_occupancy[BLACK] & bit) return BLACK;
+    return -1;
+}
+
+ChessPiece ChessPosition::pieceOn(int square) const
+{
+    int player = ownerOn(square);
+    if (player < 0) return NoPiece;
+
+    uint64_t bit = 1ULL << square;
+    const uint64_t *boards = &_pieces[player * 6];
+    for (int i = 0; i < 6; i++) {
+        if (boards[i] & bit) return (ChessPiece)(i + 1);
+    }
+    return NoPiece;
+}
+
+char ChessPosition::pieceNotation(int square) const
+{
+    const char *wpieces = { "0PNBRQK" };
+    const char *bpieces = { "0pnbrqk" };
+    int player = ownerOn(square);
+    if (player < 0) return '0';
+    return player == WHITE ? wpieces[pieceOn(square)] : bpieces[pieceOn(square)];
+}
+
+// ===========================================================
+// Attacks
+// ===========================================================
+
+uint64_t ChessPosition::attackersTo(int square, uint64_t occupied) const
+{
+    return (pawnAttacks(BLACK, square) & pieces(WHITE, Pawn))
+         | (pawnAttacks(WHITE, square) & pieces(BLACK, Pawn))
+         | (knightAttacks(square) & (pieces(WHITE, Knight) | pieces(BLACK, Knight)))
+         | (kingAttacks(square) & (pieces(WHITE, King) | pieces(BLACK, King)))
+         | (bishopAttacks(square, occupied) & (pieces(WHITE, Bishop) | pieces(BLACK, Bishop) |
+                                               pieces(WHITE, Queen) | pieces(BLACK, Queen)))
+         | (rookAttacks(square, occupied) & (pieces(WHITE, Rook) | pieces(BLACK, Rook) |
+                                             pieces(WHITE, Queen) | pieces(BLACK, Queen)));
+}
+
+bool ChessPosition::isSquareAttacked(int square, int byPlayer) const
+{
+    uint64_t occ = occupancy();
+    uint64_t queens = pieces(byPlayer, Queen);
+    return (pawnAttacks(byPlayer ^ 1, square) & pieces(byPlayer, Pawn))
+        || (knightAttacks(square) & pieces(byPlayer, Knight))
+        || (kingAttacks(square) & pieces(byPlayer, King))
+        || (bishopAttacks(square, occ) & (pieces(byPlayer, Bishop) | queens))
+        || (rookAttacks(square, occ) & (pieces(byPlayer, Rook) | queens));
+}
+
+// ===========================================================
+// Move Generator (pseudo-legal)
+// ===========================================================
+
+static int addPromotions(BitMove *moves, int count, int from, int to, uint8_t flags)
+{
+    moves[count++] = BitMove(from, to, Pawn, flags | Queen);
+    moves[count++] = BitMove(from, to, Pawn, flags | Rook);
+    moves[count++] = BitMove(from, to, Pawn, flags | Bishop);
+    moves[count++] = BitMove(from, to, Pawn, flags | Knight);
+    return count;
+}
+
+int ChessPosition::generateMoves(BitMove *moves) const
+{
+    int count = 0;
+    int us = _sideToMove;
+    int them = us ^ 1;
+    uint64_t own = _occupancy[us];
+    uint64_t enemy = _occupancy[them];
+    uint64_t occ = own | enemy;
+    uint64_t empty = ~occ;
+
+    // -------------------------------
+    // PAWN MOVES
+    // -------------------------------
+    uint64_t pawns = pieces(us, Pawn);
+    int forward = us == WHITE ? 8 : -8;
+    uint64_t lastRank = us == WHITE ? Rank8 : Rank1;
+
+    uint64_t single = us == WHITE ? (pawns << 8) & empty : (pawns >> 8) & empty;
+    uint64_t dbl = us == WHITE ? ((single & Rank3) << 8) & empty : ((single & Rank6) >> 8) & empty;
+
+    while (single) {
+        int to = popLsb(single);
+        int from = to - forward;
+        if ((1ULL << to) & lastRank)
+            count = addPromotions(moves, count, from, to, 0);
+        else
+            moves[count++] = BitMove(from, to, Pawn);
+    }
+    while (dbl) {
+        int to = popLsb(dbl);
+        moves[count++] = BitMove(to - 2 * forward, to, Pawn, BitMove::DoublePush);
+    }
+
+    uint64_t bb = pawns;
+    while (bb) {
+        int from = popLsb(bb);
+        uint64_t attacks = pawnAttacks(us, from);
+        uint64_t captures = attacks & enemy;
+        while (captures) {
+            int to = popLsb(captures);
+            if ((1ULL << to) & lastRank)
+                count = addPromotions(moves, count, from, to, BitMove::Capture);
+            else
+                moves[count++] = BitMove(from, to, Pawn, BitMove::Capture);
+        }
+        if (_epSquare >= 0 && (attacks & (1ULL << _epSquare)))
+            moves[count++] = BitMove(from, _epSquare, Pawn, BitMove::Capture | BitMove::EnPassant);
+    }
+
+    // -------------------------------
+    // PIECE MOVES (table lookups)
+    // -------------------------------
+    for (int p = Knight; p <= King; p++) {
+        ChessPiece piece = (ChessPiece)p;
+        uint64_t movers = pieces(us, piece);
+        while (movers) {
+            int from = popLsb(movers);
+            uint64_t targets;
+            switch (piece) {
+                case Knight: targets = knightAttacks(from); break;
+                case Bishop: targets = bishopAttacks(from, occ); break;
+                case Rook:   targets = rookAttacks(from, occ); break;
+                case Queen:  targets = queenAttacks(from, occ); break;
+                default:     targets = kingAttacks(from); break;
+            }
+            targets &= ~own;
+            while (targets) {
+                int to = popLsb(targets);
+                moves[count++] = BitMove(from, to, piece, (enemy & (1ULL << to)) ? BitMove::Capture : 0);
+            }
+        }
+    }
+
+    // -------------------------------
+    // CASTLING
+    // -------------------------------
+    int kingside  = us == WHITE ? WhiteKingside : BlackKingside;
+    int queenside = us == WHITE ? WhiteQueenside : BlackQueenside;
+    if (_castling & (kingside | queenside)) {
+        int base = us == WHITE ? 0 : 56;   // e1 = 4, e8 = 60
+        int king = base + 4;
+        if ((_castling & kingside) && !(occ & (0x60ULL << base)) &&
+            !isSquareAttacked(king, them) && !isSquareAttacked(king + 1, them) && !isSquareAttacked(king + 2, them)) {
+            moves[count++] = BitMove(king, king + 2, King, BitMove::Castle);
+        }
+        if ((_castling & queenside) && !(occ & (0x0EULL << base)) &&
+            !isSquareAttacked(king, them) && !isSquareAttacked(king - 1, them) && !isSquareAttacked(king - 2, them)) {
+            moves[count++] = BitMove(king, king - 2, King, BitMove::Castle);
+        }
+    }
+
+    return count;
+}
+
+// ===========================================================
+// Move Generator (legal)
+// ===========================================================
+
+// pieces of the side to move that are the only blocker between their king and an enemy slider
+uint64_t ChessPosition::pinnedPieces() const
+{
+    int us = _sideToMove;
+    int them = us ^ 1;
+    int king = kingSquare(us);
+    uint64_t occ = occupancy();
+    uint64_t queens = pieces(them, Queen);
+    uint64_t snipers = (rookAttacks(king, 0ULL) & (pieces(them, Rook) | queens)) |
+                       (bishopAttacks(king, 0ULL) & (pieces(them, Bishop) | queens));
+
+    uint64_t pinned = 0ULL;
+    while (snipers) {
+        uint64_t blockers = betweenSquares(king, popLsb(snipers)) & occ;
+        if (blockers && !(blockers & (blockers - 1))) pinned |= blockers & _occupancy[us];
+    }
+    return pinned;
+}
+
+int ChessPosition::generateLegalMoves(BitMove *moves, MoveGenType type) const
+{
+    return generateLegal(moves, type, ~0ULL);
+}
+
+// a move from anywhere (a hash table entry, a killer slot) is legal here if the
+// generator produces it for that one square
+bool ChessPosition::isLegalMove(const BitMove &move) const
+{
+    if (move.from == move.to || move.from > 63 || move.to > 63) return false;
+    if (ownerOn(move.from) != _sideToMove || pieceOn(move.from) != move.piece) return false;
+
+    BitMove moves[MAX_CHESS_MOVES];
+    int count = generateLegal(moves, GenAll, 1ULL << move.from);
+    for (int i = 0; i < count; i++) {
+        if (moves[i] == move) return true;
+    }
+    return false;
+}
+
+int ChessPosition::generateLegal(BitMove *moves, MoveGenType type, uint64_t fromMask) const
+{
+    int count = 0;
+    int us = _sideToMove;
+    int them = us ^ 1;
+    int king = kingSquare(us);
+    uint64_t own = _occupancy[us];
+    uint64_t enemy = _occupancy[them];
+    uint64_t occ = own | enemy;
+
+    bool captures = type != GenQuiets;
+    bool quiets = type != GenCaptures;
+    uint64_t typeTargets = (captures ? enemy : 0ULL) | (quiets ? ~occ : 0ULL);
+
+    uint64_t checkers = attackersTo(king, occ) & enemy;
+
+    // -------------------------------
+    // KING MOVES
+    // the king is lifted off the board so it cannot hide behind itself from a slider
+    // -------------------------------
+    uint64_t occWithoutKing = occ ^ (1ULL << king);
+    uint64_t kingTargets = (fromMask & (1ULL << king)) ? kingAttacks(king) & typeTargets : 0ULL;
+    while (kingTargets) {
+        int to = popLsb(kingTargets);
+        if (attackersTo(to, occWithoutKing) & enemy) continue;
+        moves[count++] = BitMove(king, to, King, (enemy & (1ULL << to)) ? BitMove::Capture : 0);
+    }
+
+    // double check, only the king can move
+    if (checkers & (checkers - 1)) return count;
+
+    // in check every other move must capture the checker or block its line
+    uint64_t evasion = checkers ? (checkers | betweenSquares(king, bitScan(checkers))) : ~0ULL;
+    uint64_t pinned = pinnedPieces();
+
+    // -------------------------------
+    // PAWN MOVES
+    // -------------------------------
+    int forward = us == WHITE ? 8 : -8;
+    uint64_t lastRank = us == WHITE ? Rank8 : Rank1;
+    uint64_t thirdRank = us == WHITE ? Rank3 : Rank6;
+
+    // promotions, quiet or not, count as captures: they change the material
+    uint64_t pawns = pieces(us, Pawn) & fromMask;
+    while (pawns) {
+        int from = popLsb(pawns);
+        uint64_t allowed = evasion;
+        if (pinned & (1ULL << from)) allowed &= lineSquares(king, from);
+
+        int push = from + forward;
+        uint64_t pushBit = 1ULL << push;
+        if (!(occ & pushBit)) {
+            if (allowed & pushBit) {
+                if (pushBit & lastRank) {
+                    if (captures) count = addPromotions(moves, count, from, push, 0);
+                } else if (quiets) {
+                    moves[count++] = BitMove(from, push, Pawn);
+                }
+            }
+            int jump = push + forward;
+            if (quiets && (pushBit & thirdRank) && !(occ & (1ULL << jump)) && (allowed & (1ULL << jump)))
+                moves[count++] = BitMove(from, jump, Pawn, BitMove::DoublePush);
+        }
+        if (!captures) continue;
+
+        uint64_t targets = pawnAttacks(us, from) & enemy & allowed;
+        while (targets) {
+            int to = popLsb(targets);
+            if ((1ULL << to) & lastRank)
+                count = addPromotions(moves, count, from, to, BitMove::Capture);
+            else
+                moves[count++] = BitMove(from, to, Pawn, BitMove::Capture);
+        }
+
+        // en passant empties two squares on one line at once, so it is checked in full:
+        // no slider may see the king through the gap, and a non-slider checker must be the pawn taken
+        if (_epSquare >= 0 && (pawnAttacks(us, from) & (1ULL << _epSquare))) {
+            int captured = _epSquare - forward;
+            uint64_t after = (occ ^ (1ULL << from) ^ (1ULL << captured)) | (1ULL << _epSquare);
+            uint64_t queens = pieces(them, Queen);
+            uint64_t sliders = (rookAttacks(king, after) & (pieces(them, Rook) | queens)) |
+                               (bishopAttacks(king, after) & (pieces(them, Bishop) | queens));
+            uint64_t others = checkers & (pieces(them, Pawn) | pieces(them, Knight)) & ~(1ULL << captured);
+            if (!sliders && !others)
+                moves[count++] = BitMove(from, _epSquare, Pawn, BitMove::Capture | BitMove::EnPassant);
+        }
+    }
+
+    // -------------------------------
+    // PIECE MOVES (table lookups)
+    // -------------------------------
+    for (int p = Knight; p <= Queen; p++) {
+        ChessPiece piece = (ChessPiece)p;
+        uint64_t movers = pieces(us, piece) & fromMask;
+        // a pinned knight can never stay on its line
+        if (piece == Knight) movers &= ~pinned;
+        while (movers) {
+            int from = popLsb(movers);
+            uint64_t targets;
+            switch (piece) {
+                case Knight: targets = knightAttacks(from); break;
+                case Bishop: targets = bishopAttacks(from, occ); break;
+                case Rook:   targets = rookAttacks(from, occ); break;
+                default:     targets = queenAttacks(from, occ); break;
+            }
+            targets &= typeTargets & evasion;
+            if (pinned & (1ULL << from)) targets &= lineSquares(king, from);
+            while (targets) {
+                int to = popLsb(targets);
+                moves[count++] = BitMove(from, to, piece, (enemy & (1ULL << to)) ? BitMove::Capture : 0);
+            }
+        }
+    }
+
+    // -------------------------------
+    // CASTLING
+    // never out of check, and never across or onto an attacked square
+    // -------------------------------
+    int kingside  = us == WHITE ? WhiteKingside : BlackKingside;
+    int queenside = us == WHITE ? WhiteQueenside : BlackQueenside;
+    if (quiets && !checkers && (fromMask & (1ULL << king)) && (_castling & (kingside | queenside))) {
+        int base = us == WHITE ? 0 : 56;
+        if ((_castling & kingside) && !(occ & (0x60ULL << base)) &&
+            !(attackersTo(king + 1, occ) & enemy) && !(attackersTo(king + 2, occ) & enemy)) {
+            moves[count++] = BitMove(king, king + 2, King, BitMove::Castle);
+        }
+        if ((_castling & queenside) && !(occ & (0x0EULL << base)) &&
+            !(attackersTo(king - 1, occ) & enemy) && !(attackersTo(king - 2, occ) & enemy)) {
+            moves[count++] = BitMove(king, king - 2, King, BitMove::Castle);
+        }
+    }
+
+    return count;
+}
+
+// ===========================================================
+// Move application
+// ===========================================================
+
+void ChessPosition::makeMove(const BitMove &move, ChessUndo &undo)
+{
+    int us = _sideToMove;
+    int them = us ^ 1;
+    int from = move.from;
+    int to = move.to;
+    ChessPiece piece = (ChessPiece)move.piece;
+
+    undo.key = _key;
+    undo.castling = _castling;
+    undo.epSquare = _epSquare;
+    undo.halfmoveClock = _halfmoveClock;
+    undo.captured = NoPiece;
+    undo.dirtyCount = 0;
+
+    if (move.flags & BitMove::EnPassant) {
+        int square = to + (us == WHITE ? -8 : 8);
+        undo.captured = Pawn;
+        undo.dirty[undo.dirtyCount++] = DirtyPiece{ (uint8_t)them, Pawn, (int8_t)square, -1 };
+        removePiece(them, Pawn, square);
+    } else if (move.flags & BitMove::Capture) {
+        undo.captured = pieceOn(to);
+        undo.dirty[undo.dirtyCount++] = DirtyPiece{ (uint8_t)them, (uint8_t)undo.captured, (int8_t)to, -1 };
+        removePiece(them, undo.captured, to);
+    }
+
+    removePiece(us, piece, from);
+    if (move.promotion()) {
+        undo.dirty[undo.dirtyCount++] = DirtyPiece{ (uint8_t)us, (uint8_t)piece, (int8_t)from, -1 };
+        undo.dirty[undo.dirtyCount++] = DirtyPiece{ (uint8_t)us, move.promotion(), -1, (int8_t)to };
+        putPiece(us, (ChessPiece)move.promotion(), to);
+    } else {
+        undo.dirty[undo.dirtyCount++] = DirtyPiece{ (uint8_t)us, (uint8_t)piece, (int8_t)from, (int8_t)to };
+        putPiece(us, piece, to);
+    }
+
+    if (move.flags & BitMove::Castle) {
+        int rookFrom = to > from ? to + 1 : to - 2;
+        int rookTo   = to > from ? to - 1 : to + 1;
+        undo.dirty[undo.dirtyCount++] = DirtyPiece{ (uint8_t)us, Rook, (int8_t)rookFrom, (int8_t)rookTo };
+        removePiece(us, Rook, rookFrom);
+        putPiece(us, Rook, rookTo);
+    }
+
+    if (_epSquare >= 0) _key ^= Zobrist.epFile[_epSquare & 7];
+    _key ^= Zobrist.castling[_castling];
+
+    _castling &= CastlingMask[from] & CastlingMask[to];
+    // only a square a pawn can take on: otherwise the position would never repeat the same one
+    // reached later without it
+    _epSquare = -1;
+    if (move.flags & BitMove::DoublePush) {
+        int square = (from + to) / 2;
+        if (pawnAttacks(us, square) & pieces(them, Pawn)) _epSquare = (int8_t)square;
+    }
+
+    _key ^= Zobrist.castling[_castling];
+    if (_epSquare >= 0) _key ^= Zobrist.epFile[_epSquare & 7];
+    _key ^= Zobrist.side;
+
+    if (piece == Pawn || (move.flags & BitMove::Capture))
+        _halfmoveClock = 0;
+    else if (_halfmoveClock < 255)
+        _halfmoveClock++;
+
+    if (us == BLACK) _fullmoveNumber++;
+    _sideToMove = (uint8_t)them;
+}
+
+void ChessPosition::unmakeMove(const BitMove &move, const ChessUndo &undo)
+{
+    int them = _sideToMove;
+    int us = them ^ 1;
+    int from = move.from;
+    int to = move.to;
+    ChessPiece piece = (ChessPiece)move.piece;
+
+    _sideToMove = (uint8_t)us;
+    if (us == BLACK) _fullmoveNumber--;
+
+    if (move.flags & BitMove::Castle) {
+        int rookFrom = to > from ? to + 1 : to - 2;
+        int rookTo   = to > from ? to - 1 : to + 1;
+        removePiece(us, Rook, rookTo);
+        putPiece(us, Rook, rookFrom);
+    }
+
+    removePiece(us, move.promotion() ? (ChessPiece)move.promotion() : piece, to);
+    putPiece(us, piece, from);
+
+    if (move.flags & BitMove::EnPassant) {
+        putPiece(them, Pawn, to + (us == WHITE ? -8 : 8));
+    } else if (undo.captured != NoPiece) {
+        putPiece(them, undo.captured, to);
+    }
+
+    // the piece edits above toggled the key back and forth, restore it exactly
+    _key = undo.key;
+    _castling = undo.castling;
+    _epSquare = undo.epSquare;
+    _halfmoveClock = undo.halfmoveClock;
+}
+
+// ===========================================================
+// Game end rules
+// ===========================================================
+
+bool ChessPosition::isRepetition(const uint64_t *keys, int keyCount, int count) const
+{
+    // captures and pawn moves cannot be undone, nothing before the last one can come back.
+    // only every other key has the same side to move
+    int depth = std::min<int>(_halfmoveClock, keyCount);
+    int found = 0;
+    for (int back = 4; back <= depth; back += 2) {
+        if (keys[keyCount - back] == _key && ++found >= count) return true;
+    }
+    return false;
+}
+
+bool ChessPosition::isFiftyMoveDraw() const
+{
+    if (_halfmoveClock < 100) return false;
+    // checkmate on the hundredth ply still counts
+    BitMove moves[MAX_CHESS_MOVES];
+    return !inCheck() || generateLegalMoves(moves) > 0;
+}
+
+bool ChessPosition::hasInsufficientMaterial() const
+{
+    uint64_t heavy = 0ULL;
+    for (int player = WHITE; player <= BLACK; player++)
+        heavy |= pieces(player, Pawn) | pieces(player, Rook) | pieces(player, Queen);
+    if (heavy) return false;
+
+    uint64_t knights = pieces(WHITE, Knight) | pieces(BLACK, Knight);
+    uint64_t bishops = pieces(WHITE, Bishop) | pieces(BLACK, Bishop);
+    if (popCount(knights | bishops) <= 1) return true;
+    // any number of bishops, all on light squares or all on dark ones, can never give mate
+    const uint64_t darkSquares = 0xAA55AA55AA55AA55ULL;
+    return !knights && ((bishops & darkSquares) == 0 || (bishops & ~darkSquares) == 0);
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "bitboard.h"
+#include "ChessAttacks.h"
+
+enum ChessPiece
+{
+    NoPiece,
+    Pawn,
+    Knight,
+    Bishop,
+    Rook,
+    Queen,
+    King
+};
+
+// player numbers match Game::getPlayerAt(), white always moves first
+const int WHITE = 0;
+const int BLACK = 1;
+
+enum CastlingRights
+{
+    WhiteKingside  = 1,
+    WhiteQueenside = 2,
+    BlackKingside  = 4,
+    BlackQueenside = 8,
+    AllCastling    = 15
+};
+
+// enough room for any legal chess position (the known maximum is 218)
+const int MAX_CHESS_MOVES = 256;
+
+// which part of the legal moves to generate, the two halves together make GenAll
+enum MoveGenType
+{
+    GenAll,
+    GenCaptures,    // captures, en passant and every promotion
+    GenQuiets       // everything else, castling included
+};
+
+// a piece a move put down, took off or moved, for evaluations updated move by move.
+// from is -1 for a piece that appeared (promotion), to is -1 for one taken off the board
+struct DirtyPiece
+{
+    uint8_t player;
+    uint8_t piece;      // ChessPiece
+    int8_t  from;
+    int8_t  to;
+};
+
+//
+// everything makeMove() overwrites that unmakeMove() cannot work out from the move itself.
+// callers keep these on a stack, one per move made.
+//
+struct ChessUndo
+{
+    uint64_t   key;
+    ChessPiece captured;
+    uint8_t    castling;
+    int8_t     epSquare;
+    uint8_t    halfmoveClock;
+    // at most three: a capturing promotion removes two pieces and adds one
+    uint8_t    dirtyCount;
+    DirtyPiece dirty[3];
+};
+
+// long algebraic notation as used by UCI, e.g. "e2e4" or "e7e8q"
+std::string moveToString(const BitMove &move);
+
+//
+// compact bitboard chess position
+//
+// this is a plain value type: it owns no heap memory and can be copied with memcpy,
+// so the rules and the search work on it directly. the Grid of ChessSquares and
+// their Bit sprites only mirror it for display.
+//
+class ChessPosition
+{
+public:
+    static const char *StartFEN;
+
+    ChessPosition() { clear(); }
+
+    void clear();
+    // loads all six FEN fields, the two clocks may be left off.
+    // returns false if the placement, kings or side to move are malformed
+    bool setFEN(const std::string &fen);
+    std::string toFEN() const;
+
+    // piece access
+    uint64_t pieces(int player, ChessPiece piece) const { return _pieces[pieceIndex(player, piece)]; }
+    uint64_t occupancy(int player) const { return _occupancy[player]; }
+    uint64_t occupancy() const { return _occupancy[WHITE] | _occupancy[BLACK]; }
+    ChessPiece pieceOn(int square) const;
+    int ownerOn(int square) const;   // -1 when the square is empty
+    int kingSquare(int player) const { return bitScan(pieces(player, King)); }
+
+    // game state
+    int sideToMove() const { return _sideToMove; }
+    int castlingRights() const { return _castling; }
+    int enPassantSquare() const { return _epSquare; }   // -1 when there is none or no pawn can take
+    int halfmoveClock() const { return _halfmoveClock; }
+    int fullmoveNumber() const { return _fullmoveNumber; }
+
+    // game end rules. mate and stalemate are left to the caller, who generates the moves anyway.
+    // true if this position, same side to move, came up at least count times before since the
+    // last capture or pawn move. one is enough inside a search, three-fold is count = 2.
+    // keys are those of the positions that led here, oldest first and the one a ply back last;
+    // the game and the search keep them, so a position stays cheap to copy
+    bool isRepetition(const uint64_t *keys, int keyCount, int count = 1) const;
+    // a hundred plies without a capture or pawn move, unless this move is checkmate
+    bool isFiftyMoveDraw() const;
+    // no sequence of legal moves can mate: bare kings, a single minor piece, or only bishops on one colour
+    bool hasInsufficientMaterial() const;
+    // any of the three, cheap enough to call at every node
+    bool isDrawByRule(const uint64_t *keys, int keyCount, int repetitions = 1) const
+    {
+        return isRepetition(keys, keyCount, repetitions) || hasInsufficientMaterial() || isFiftyMoveDraw();
+    }
+
+    // zobrist hash, kept up to date by every edit
+    uint64_t key() const { return _key; }
+    // the same hash rebuilt from scratch, for checking the incremental one
+    uint64_t computeKey() const;
+    // hash of the pawns alone, for the pawn structure cache
+    uint64_t pawnKey() const { return _pawnKey; }
+    uint64_t computePawnKey() const;
+
+    // material + piece-square sums from white's side (see ChessPSQT.h) and the
+    // game phase, also kept up to date by every edit
+    int pieceSquareMg() const { return _psqMg; }
+    int pieceSquareEg() const { return _psqEg; }
+    int phase() const { return _phase; }
+    void computePieceSquare(int &mg, int &eg, int &phase) const;
+
+    // attack queries
+    uint64_t attackersTo(int square, uint64_t occupied) const;
+    bool isSquareAttacked(int square, int byPlayer) const;
+    bool inCheck() const { return isSquareAttacked(kingSquare(_sideToMove), _sideToMove ^ 1); }
+
+    // pseudo-legal moves for the side to move, returns the number written to moves.
+    // some may leave the king in check, the caller has to make them to find out
+    int generateMoves(BitMove *moves) const;
+    // only the legal moves: checkers, pins and the evasion mask are worked out once up front
+    int generateLegalMoves(BitMove *moves, MoveGenType type = GenAll) const;
+    // true if the move, which may come from another position, is legal in this one
+    bool isLegalMove(const BitMove &move) const;
+    // own pieces that may only move along the line to their king
+    uint64_t pinnedPieces() const;
+
+    // apply a move generated for this position, saving what is needed to take it back
+    void makeMove(const BitMove &move, ChessUndo &undo);
+    // take back the last move made, with the undo record makeMove() filled in
+    void unmakeMove(const BitMove &move, const ChessUndo &undo);
+
+    // board editing, keeps occupancy and the key in sync
+    void putPiece(int player, ChessPiece piece, int square);
+    void removePiece(int player, ChessPiece piece, int square);
+    void setSideToMove(int player);
+
+    // 'P', 'n', ... or '0' for an empty square
+    char pieceNotation(int square) const;
+
+private:
+    int generateLegal(BitMove *moves, MoveGenType type, uint64_t fromMask) const;
+
+    static int pieceIndex(int player, ChessPiece piece) { return player * 6 + (piece - 1); }
+
+    uint64_t _pieces[12];       // [player * 6 + piece - 1]
+    uint64_t _occupancy[2];     // per player
+    uint64_t _key;
+    uint64_t _pawnKey;
+    uint8_t  _sideToMove;
+    uint8_t  _castling;         // CastlingRights bits
+    int8_t   _epSquare;
+    uint8_t  _halfmoveClock;
+    uint16_t _fullmoveNumber;
+    int16_t  _psqMg;
+    int16_t  _psqEg;
+    uint8_t  _phase;            // can pass MaxPhase after promotions
+};
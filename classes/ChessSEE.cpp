@@ -0,0 +1,77 @@
+#include "ChessSEE.h"
+#include <algorithm>
+#include "ChessEvaluate.h"
+
+// ===========================================================
+// Static exchange evaluation (swap list)
+// ===========================================================
+
+int see(const ChessPosition &position, const BitMove &move)
+{
+    int from = move.from;
+    int to = move.to;
+    if (move.flags & BitMove::Castle) return 0;
+
+    int gain[32];
+    int depth = 0;
+
+    uint64_t occ = position.occupancy();
+    ChessPiece victim = position.pieceOn(to);
+    if (move.flags & BitMove::EnPassant) {
+        victim = Pawn;
+        occ ^= 1ULL << (to + (position.sideToMove() == WHITE ? -8 : 8));
+    }
+
+    // a promoting pawn stands on the square as the new piece
+    ChessPiece onSquare = move.promotion() ? (ChessPiece)move.promotion() : (ChessPiece)move.piece;
+    gain[0] = PieceValue[victim];
+    if (move.promotion()) gain[0] += PieceValue[move.promotion()] - PieceValue[Pawn];
+
+    uint64_t diagonal = position.pieces(WHITE, Bishop) | position.pieces(BLACK, Bishop) |
+                        position.pieces(WHITE, Queen) | position.pieces(BLACK, Queen);
+    uint64_t straight = position.pieces(WHITE, Rook) | position.pieces(BLACK, Rook) |
+                        position.pieces(WHITE, Queen) | position.pieces(BLACK, Queen);
+
+    occ ^= 1ULL << from;
+    uint64_t attackers = position.attackersTo(to, occ) & occ;
+    int side = position.sideToMove() ^ 1;
+
+    while (true) {
+        uint64_t ours = attackers & position.occupancy(side);
+        if (!ours) break;
+
+        // least valuable attacker
+        ChessPiece piece = Pawn;
+        uint64_t bit = 0;
+        for (int p = Pawn; p <= King; p++) {
+            uint64_t bb = ours & position.pieces(side, (ChessPiece)p);
+            if (bb) {
+                piece = (ChessPiece)p;
+                bit = bb & (0 - bb);
+                break;
+            }
+        }
+        // the king may only take last, onto a square nothing guards any more
+        if (piece == King && (attackers & position.occupancy(side ^ 1))) break;
+
+        // what this side stands to win by taking, if the other side stopped there.
+        // when both taking and standing pat lose, the capture cannot change the result
+        int take = PieceValue[onSquare] - gain[depth];
+        if (std::max(-gain[depth], take) < 0 || depth == 31) break;
+        gain[++depth] = take;
+
+        occ ^= bit;
+        if (piece == Pawn || piece == Bishop || piece == Queen) attackers |= bishopAttacks(to, occ) & diagonal;
+        if (piece == Rook || piece == Queen) attackers |= rookAttacks(to, occ) & straight;
+        attackers &= occ;
+
+        onSquare = piece;
+        side ^= 1;
+    }
+
+    while (depth > 0) {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+        depth--;
+    }
+    return gain[0];
+}
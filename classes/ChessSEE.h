@@ -0,0 +1,11 @@
+#pragma once
+
+#include "ChessPosition.h"
+
+//
+// static exchange evaluation: the material balance, in PieceValue centipawns, of
+// the capture sequence on the move's target square when both sides always
+// recapture with their least valuable piece and may stop whenever it suits them.
+// sliders lined up behind the capturers (x-rays) join in as the square opens up.
+//
+int see(const ChessPosition &position, const BitMove &move);
@@ -0,0 +1,461 @@
+#include "ChessSearch.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include "ChessEvaluate.h"
+#include "ChessSEE.h"
+
+// mate and tablebase scores are stored relative to the node, not the root, so they stay valid at any ply
+static const int SCORE_DECIDED = SCORE_TB_WIN - MAX_PLY;
+
+static int scoreToTT(int score, int ply)
+{
+    if (score >= SCORE_DECIDED) return score + ply;
+    if (score <= -SCORE_DECIDED) return score - ply;
+    return score;
+}
+
+static int scoreFromTT(int score, int ply)
+{
+    if (score >= SCORE_DECIDED) return score - ply;
+    if (score <= -SCORE_DECIDED) return score + ply;
+    return score;
+}
+
+// UCI has no tablebase score: a win goes out as centipawns just under this, minus its distance,
+// a band no evaluation reaches and GUIs already read as a tablebase result
+static const int TB_WIN_CP = 20000;
+
+std::string formatReport(const SearchReport &report)
+{
+    std::ostringstream out;
+    out << "info depth " << report.depth << " seldepth " << report.seldepth << " score ";
+    if (report.score >= SCORE_MATE_IN_MAX)
+        out << "mate " << (SCORE_MATE - report.score + 1) / 2;
+    else if (report.score <= -SCORE_MATE_IN_MAX)
+        out << "mate " << -(SCORE_MATE + report.score) / 2;
+    else if (report.score >= SCORE_DECIDED)
+        out << "cp " << TB_WIN_CP - (SCORE_TB_WIN - report.score);
+    else if (report.score <= -SCORE_DECIDED)
+        out << "cp " << -TB_WIN_CP + (SCORE_TB_WIN + report.score);
+    else
+        out << "cp " << report.score;
+    out << " nodes " << report.nodes << " nps " << report.nps << " hashfull " << report.hashfull;
+    if (report.tbHits) out << " tbhits " << report.tbHits;
+    out << " time " << report.timeMs << " pv";
+    for (const BitMove &move : report.pv) out << " " << moveToString(move);
+    return out.str();
+}
+
+ChessSearch::ChessSearch(TranspositionTable &tt)
+    : _tt(tt), _stop(false), _stopFlag(&_stop), _nodes(0), _pondering(false), _budgetStartMs(0), _seldepth(0),
+      _gameKeyCount(0), _network(nullptr),
+      _accumulators(MAX_PLY + 2), _tablebase(nullptr), _tbProbeDepth(1), _tbPieceLimit(0), _tbHits(0)
+{
+    _reporter = [](const SearchReport &report) { std::cout << formatReport(report) << std::endl; };
+}
+
+ChessSearch::ChessSearch(TranspositionTable &tt, std::atomic<bool> *stopFlag)
+    : _tt(tt), _stop(false), _stopFlag(stopFlag), _nodes(0), _pondering(false), _budgetStartMs(0), _seldepth(0),
+      _gameKeyCount(0), _network(nullptr),
+      _accumulators(MAX_PLY + 2), _tablebase(nullptr), _tbProbeDepth(1), _tbPieceLimit(0), _tbHits(0)
+{
+}
+
+void ChessSearch::setThreads(int count)
+{
+    if (count < 1) count = 1;
+    _helpers.resize(count - 1);
+    for (auto &helper : _helpers) {
+        if (!helper) helper.reset(new ChessSearch(_tt, &_stop));
+        helper->_network = _network;
+        helper->setTablebase(_tablebase, _tbProbeDepth, _tbPieceLimit);
+    }
+}
+
+void ChessSearch::setNetwork(const ChessNetwork *network)
+{
+    _network = network;
+    for (auto &helper : _helpers) helper->_network = network;
+}
+
+void ChessSearch::setTablebase(const ChessTablebase *tablebase, int probeDepth, int pieceLimit)
+{
+    _tablebase = tablebase;
+    _tbProbeDepth = std::max(1, probeDepth);
+    _tbPieceLimit = pieceLimit;
+    for (auto &helper : _helpers) helper->setTablebase(tablebase, probeDepth, pieceLimit);
+}
+
+void ChessSearch::pawnTableStats(uint64_t &hits, uint64_t &probes) const
+{
+    hits = _pawnTable.hits();
+    probes = _pawnTable.probes();
+    for (const auto &helper : _helpers) {
+        hits += helper->_pawnTable.hits();
+        probes += helper->_pawnTable.probes();
+    }
+}
+
+uint64_t ChessSearch::totalNodes() const
+{
+    uint64_t nodes = _nodes.load(std::memory_order_relaxed);
+    for (const auto &helper : _helpers) nodes += helper->_nodes.load(std::memory_order_relaxed);
+    return nodes;
+}
+
+uint64_t ChessSearch::totalTbHits() const
+{
+    uint64_t hits = _tbHits.load(std::memory_order_relaxed);
+    for (const auto &helper : _helpers) hits += helper->_tbHits.load(std::memory_order_relaxed);
+    return hits;
+}
+
+// ===========================================================
+// Root / iterative deepening
+// ===========================================================
+
+void ChessSearch::prepare(bool ponder)
+{
+    _stop.store(false, std::memory_order_relaxed);
+    _pondering.store(ponder, std::memory_order_relaxed);
+    _start = std::chrono::steady_clock::now();
+    _budgetStartMs.store(0, std::memory_order_relaxed);
+}
+
+BitMove ChessSearch::search(const ChessPosition &root, const SearchLimits &limits, const std::vector<uint64_t> &history)
+{
+    _pos = root;
+    _limits = limits;
+    _gameKeyCount = std::min<int>({ (int)history.size(), root.halfmoveClock(), GameKeys });
+    std::copy(history.end() - _gameKeyCount, history.end(), _keys);
+    _nodes.store(0, std::memory_order_relaxed);
+    _tbHits.store(0, std::memory_order_relaxed);
+    _report = SearchReport();
+    _tt.newSearch();
+    _pawnTable.resetStats();
+    if (_network) _network->refresh(_pos, _accumulators[0]);
+    resetOrdering();
+
+    BitMove moves[MAX_CHESS_MOVES];
+    BitMove best;
+    if (_pos.generateLegalMoves(moves) == 0 || rootTablebaseMove(best)) {
+        _pondering.store(false, std::memory_order_relaxed);
+        return best;
+    }
+    // fall back to any legal move in case even depth 1 gets cut short
+    best = moves[0];
+
+    int maxDepth = limits.maxDepth < MAX_PLY - 1 ? limits.maxDepth : MAX_PLY - 1;
+
+    // helpers only stop on the shared flag, this thread owns the limits.
+    // every other helper starts a ply deeper so the threads drift apart and
+    // fill the table with different subtrees.
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < _helpers.size(); i++) {
+        ChessSearch *helper = _helpers[i].get();
+        helper->_pos = root;
+        helper->_gameKeyCount = _gameKeyCount;
+        std::copy(_keys, _keys + _gameKeyCount, helper->_keys);
+        helper->_limits = SearchLimits();
+        helper->_limits.maxDepth = maxDepth;
+        helper->_nodes.store(0, std::memory_order_relaxed);
+        helper->_tbHits.store(0, std::memory_order_relaxed);
+        helper->_start = _start;
+        helper->_pawnTable.resetStats();
+        if (_network) _network->refresh(root, helper->_accumulators[0]);
+        helper->resetOrdering();
+        threads.emplace_back([helper, i] { helper->helperSearch(1 + (int)(i & 1)); });
+    }
+
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        _seldepth = 0;
+        int score = negamax(depth, 0, -SCORE_INFINITE, SCORE_INFINITE, true);
+
+        // an aborted iteration is only trusted at depth 1, where anything beats the fallback
+        if (_stop.load(std::memory_order_relaxed) && (depth > 1 || _pvLength[0] == 0)) break;
+
+        best = _pv[0][0];
+
+        uint64_t nodes = totalNodes();
+        _report.depth = depth;
+        _report.seldepth = _seldepth;
+        _report.score = score;
+        _report.nodes = nodes;
+        _report.timeMs = elapsedMs();
+        _report.nps = _report.timeMs > 0 ? nodes * 1000 / _report.timeMs : nodes;
+        _report.hashfull = _tt.hashfull();
+        _report.tbHits = totalTbHits();
+        _report.pv.assign(&_pv[0][0], &_pv[0][0] + _pvLength[0]);
+        if (_reporter) _reporter(_report);
+
+        if (_stop.load(std::memory_order_relaxed)) break;
+        // a mate within the searched depth cannot get any shorter
+        if (std::abs(score) >= SCORE_MATE_IN_MAX && depth >= SCORE_MATE - std::abs(score)) break;
+        // while pondering there is no budget yet, the search goes on until the hit or a stop
+        if (pondering()) continue;
+        if (depth >= limits.minDepth && limits.softTimeMs && budgetMs() >= limits.softTimeMs) break;
+        if (limits.maxNodes && nodes >= limits.maxNodes) break;
+    }
+
+    _stop.store(true, std::memory_order_relaxed);
+    _pondering.store(false, std::memory_order_relaxed);
+    for (std::thread &thread : threads) thread.join();
+    return best;
+}
+
+// the DTZ move keeps a won position won and makes progress towards the next zeroing
+// move, which a search that only sees WDL values at its leaves cannot promise
+bool ChessSearch::rootTablebaseMove(BitMove &move)
+{
+    if (!_tablebase || !ChessTablebase::probeable(_pos, _tbPieceLimit)) return false;
+    TBValue value;
+    int dtz;
+    if (!_tablebase->probeRoot(_pos, move, value, dtz)) return false;
+
+    _report.depth = 1;
+    _report.score = value == TBWin ? SCORE_TB_WIN - dtz : value == TBLoss ? -SCORE_TB_WIN + dtz : 0;
+    _report.timeMs = elapsedMs();
+    _report.tbHits = 1;
+    _report.pv.assign(1, move);
+    if (_reporter) _reporter(_report);
+    return true;
+}
+
+void ChessSearch::helperSearch(int startDepth)
+{
+    for (int depth = startDepth; depth <= _limits.maxDepth && !stopped(); depth++) {
+        _seldepth = 0;
+        negamax(depth, 0, -SCORE_INFINITE, SCORE_INFINITE, true);
+    }
+}
+
+int64_t ChessSearch::elapsedMs() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _start).count();
+}
+
+void ChessSearch::ponderHit()
+{
+    // the budget starts now, then the limits are switched on
+    _budgetStartMs.store(elapsedMs(), std::memory_order_relaxed);
+    _pondering.store(false, std::memory_order_release);
+}
+
+bool ChessSearch::timeUp()
+{
+    if (pondering()) return false;
+    if (_limits.hardTimeMs && budgetMs() >= _limits.hardTimeMs) return true;
+    if (_limits.maxNodes && totalNodes() >= _limits.maxNodes) return true;
+    return false;
+}
+
+// the network's accumulators are brought up to date lazily: walk back to the
+// nearest ply that is (the root always is) and apply the moves from there
+int ChessSearch::staticEval(int ply)
+{
+    if (!_network) return evaluate(_pos, _pawnTable);
+
+    int base = ply;
+    while (!_accumulators[base].computed) base--;
+    for (int i = base + 1; i <= ply; i++) _network->update(_accumulators[i - 1], _accumulators[i]);
+    return _network->evaluate(_pos, _accumulators[ply]);
+}
+
+// ===========================================================
+// Move ordering heuristics
+// ===========================================================
+
+void ChessSearch::resetOrdering()
+{
+    _history.age();
+    for (auto &killers : _killers) killers[0] = killers[1] = BitMove();
+}
+
+// a quiet move caused a cutoff: make it the first killer at this ply and reward it
+// in the history table, the quiets searched before it get the same amount taken off
+void ChessSearch::updateQuietStats(int ply, int depth, const BitMove &move, const BitMove *tried, int triedCount)
+{
+    if (!(_killers[ply][0] == move)) {
+        _killers[ply][1] = _killers[ply][0];
+        _killers[ply][0] = move;
+    }
+
+    int us = _pos.sideToMove();
+    int bonus = depth * depth;
+    _history.update(us, move, bonus);
+    for (int i = 0; i < triedCount; i++) _history.update(us, tried[i], -bonus);
+}
+
+// ===========================================================
+// Principal variation search
+// ===========================================================
+
+int ChessSearch::negamax(int depth, int ply, int alpha, int beta, bool pvNode)
+{
+    _pvLength[ply] = ply;
+
+    if (depth <= 0) return quiescence(ply, alpha, beta);
+
+    if ((countNode() & 1023) == 0 && timeUp()) _stopFlag->store(true, std::memory_order_relaxed);
+    if (stopped()) return 0;
+    // a single repetition inside the tree is scored as the draw it can be forced into
+    if (ply > 0 && _pos.isDrawByRule(_keys, _gameKeyCount + ply)) return 0;
+    if (ply >= MAX_PLY) return staticEval(ply);
+
+    if (ply > 0) {
+        // mate distance pruning: no score here can beat a shorter mate already found
+        alpha = std::max(alpha, -SCORE_MATE + ply);
+        beta = std::min(beta, SCORE_MATE - ply - 1);
+        if (alpha >= beta) return alpha;
+    }
+
+    uint64_t key = _pos.key();
+    _keys[_gameKeyCount + ply] = key;
+    BitMove ttMove;
+    TTData tt;
+    if (_tt.probe(key, tt)) {
+        ttMove = tt.move;
+        if (!pvNode && tt.depth >= depth) {
+            int score = scoreFromTT(tt.score, ply);
+            if (tt.bound == BoundExact ||
+                (tt.bound == BoundLower && score >= beta) ||
+                (tt.bound == BoundUpper && score <= alpha)) {
+                return score;
+            }
+        }
+    }
+
+    // a position in the tables is decided: win, draw or loss, however deep the search would go
+    if (ply > 0 && _tablebase && depth >= _tbProbeDepth && ChessTablebase::probeable(_pos, _tbPieceLimit)) {
+        TBValue value;
+        if (_tablebase->probeWDL(_pos, value)) {
+            _tbHits.fetch_add(1, std::memory_order_relaxed);
+            int score = value == TBWin ? SCORE_TB_WIN - ply : value == TBLoss ? -SCORE_TB_WIN + ply : 0;
+            _tt.store(key, BitMove(), scoreToTT(score, ply), MAX_PLY - 1, BoundExact);
+            return score;
+        }
+    }
+
+    bool inCheck = _pos.inCheck();
+    if (inCheck) depth++;
+
+    ChessMovePicker picker(_pos, ttMove, _killers[ply], _history);
+    BitMove quietsTried[64];
+    int quietCount = 0;
+
+    int oldAlpha = alpha;
+    int best = -SCORE_INFINITE;
+    BitMove bestMove;
+    int moveCount = 0;
+    BitMove move;
+
+    while (picker.next(move)) {
+        bool quiet = !move.isCapture() && !move.promotion();
+
+        // SEE pruning: near the leaves, captures that lose more than a pawn per ply left are skipped
+        if (!pvNode && !inCheck && moveCount > 0 && depth <= 3 && move.isCapture() &&
+            best > -SCORE_MATE_IN_MAX && see(_pos, move) < -100 * depth) {
+            continue;
+        }
+        moveCount++;
+
+        ChessUndo undo;
+        _pos.makeMove(move, undo);
+        // the child probes its bucket first thing, quiescence never does
+        if (depth > 1) _tt.prefetch(_pos.key());
+        pushAccumulator(ply + 1, undo);
+
+        int score;
+        if (moveCount == 1) {
+            score = -negamax(depth - 1, ply + 1, -beta, -alpha, pvNode);
+        } else {
+            // null window first, re-search only if it might raise alpha
+            score = -negamax(depth - 1, ply + 1, -alpha - 1, -alpha, false);
+            if (pvNode && score > alpha && score < beta)
+                score = -negamax(depth - 1, ply + 1, -beta, -alpha, true);
+        }
+        _pos.unmakeMove(move, undo);
+
+        if (stopped()) return 0;
+
+        if (score > best) {
+            best = score;
+            bestMove = move;
+            if (score > alpha) {
+                alpha = score;
+                _pv[ply][ply] = move;
+                for (int j = ply + 1; j < _pvLength[ply + 1]; j++) _pv[ply][j] = _pv[ply + 1][j];
+                _pvLength[ply] = _pvLength[ply + 1] > ply + 1 ? _pvLength[ply + 1] : ply + 1;
+                if (alpha >= beta) {
+                    if (quiet) updateQuietStats(ply, depth, move, quietsTried, quietCount);
+                    break;
+                }
+            }
+        }
+        if (quiet && quietCount < 64) quietsTried[quietCount++] = move;
+    }
+
+    if (moveCount == 0) return inCheck ? -SCORE_MATE + ply : 0;
+
+    TTBound bound = best >= beta ? BoundLower : (best > oldAlpha ? BoundExact : BoundUpper);
+    _tt.store(key, bestMove, scoreToTT(best, ply), depth, bound);
+    return best;
+}
+
+// ===========================================================
+// Quiescence: captures and promotions until the position is quiet
+// ===========================================================
+
+int ChessSearch::quiescence(int ply, int alpha, int beta)
+{
+    _pvLength[ply] = ply;
+
+    if ((countNode() & 1023) == 0 && timeUp()) _stopFlag->store(true, std::memory_order_relaxed);
+    if (stopped()) return 0;
+    if (ply > _seldepth) _seldepth = ply;
+    if (ply >= MAX_PLY) return staticEval(ply);
+
+    bool inCheck = _pos.inCheck();
+    int best = -SCORE_INFINITE;
+
+    // standing pat is not an option while in check, every evasion is searched instead
+    if (!inCheck) {
+        best = staticEval(ply);
+        if (best >= beta) return best;
+        if (best > alpha) alpha = best;
+    }
+
+    ChessMovePicker picker(_pos, _history);
+    int moveCount = 0;
+    BitMove move;
+
+    while (picker.next(move)) {
+        moveCount++;
+
+        ChessUndo undo;
+        _pos.makeMove(move, undo);
+        pushAccumulator(ply + 1, undo);
+
+        int score = -quiescence(ply + 1, -beta, -alpha);
+        _pos.unmakeMove(move, undo);
+
+        if (stopped()) return 0;
+
+        if (score > best) {
+            best = score;
+            if (score > alpha) {
+                alpha = score;
+                _pv[ply][ply] = move;
+                for (int j = ply + 1; j < _pvLength[ply + 1]; j++) _pv[ply][j] = _pv[ply + 1][j];
+                _pvLength[ply] = _pvLength[ply + 1] > ply + 1 ? _pvLength[ply + 1] : ply + 1;
+                if (alpha >= beta) break;
+            }
+        }
+    }
+
+    if (inCheck && moveCount == 0) return -SCORE_MATE + ply;
+    return best;
+}
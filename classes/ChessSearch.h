@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ChessMovePicker.h"
+#include "ChessNNUE.h"
+#include "ChessPawnTable.h"
+#include "ChessPosition.h"
+#include "ChessTablebase.h"
+#include "ChessTT.h"
+
+const int MAX_PLY            = 128;
+const int SCORE_INFINITE     = 32001;
+const int SCORE_MATE         = 32000;
+const int SCORE_MATE_IN_MAX  = SCORE_MATE - MAX_PLY;
+// tablebase wins rank below every mate the search can see, minus the ply they were found at
+const int SCORE_TB_WIN       = SCORE_MATE_IN_MAX - MAX_PLY;
+
+struct SearchLimits
+{
+    int      maxDepth   = MAX_PLY - 1;
+    int      minDepth   = 1;    // always completed unless the hard limit or stop() cuts in
+    int64_t  softTimeMs = 0;    // no new iteration is started past this, 0 = none
+    int64_t  hardTimeMs = 0;    // the search is aborted past this, 0 = none
+    uint64_t maxNodes   = 0;    // 0 = none
+};
+
+// one line of progress, produced after every completed iteration
+struct SearchReport
+{
+    int                  depth    = 0;
+    int                  seldepth = 0;
+    int                  score    = 0;
+    uint64_t             nodes    = 0;
+    int64_t              timeMs   = 0;
+    uint64_t             nps      = 0;
+    int                  hashfull = 0;
+    uint64_t             tbHits   = 0;
+    std::vector<BitMove> pv;
+};
+
+// "info depth 8 seldepth 14 score cp 23 nodes ... nps ... time ... pv e2e4 e7e5"
+std::string formatReport(const SearchReport &report);
+
+//
+// principal variation alpha-beta search with iterative deepening,
+// quiescence search on captures and a soft/hard time budget
+//
+// with more than one thread the search is Lazy SMP: helper threads search the
+// same root at staggered depths and only talk to each other through the shared
+// transposition table. the calling thread's result is the one returned.
+//
+class ChessSearch
+{
+public:
+    explicit ChessSearch(TranspositionTable &tt);
+
+    // search the position and return the best move found, or a null move (from == to) with no legal moves.
+    // prepare() must have been called first. history holds the keys of the game's positions before
+    // the root, oldest first, so the search sees repetitions of them
+    BitMove search(const ChessPosition &root, const SearchLimits &limits,
+                   const std::vector<uint64_t> &history = std::vector<uint64_t>());
+
+    // clears the last search's stop and starts the clock for the next search(). call it on the
+    // thread that may stop() or ponderHit(), before handing search() to another one, so neither
+    // is lost when it comes before that thread gets going. with ponder the search runs on the
+    // position after the opponent's expected reply and ignores its time and node limits until
+    // ponderHit()
+    void prepare(bool ponder = false);
+
+    // safe to call from another thread, the search returns its best move so far
+    void stop() { _stop.store(true, std::memory_order_relaxed); }
+
+    // the opponent played the expected move: the limits apply from now, the depth reached so
+    // far is kept. safe to call from another thread
+    void ponderHit();
+    bool pondering() const { return _pondering.load(std::memory_order_relaxed); }
+
+    // total threads used by search(), including the calling one. not to be changed mid-search
+    void setThreads(int count);
+    int threads() const { return (int)_helpers.size() + 1; }
+
+    // evaluate with this network instead of the hand-written evaluation, nullptr to go back.
+    // the network must outlive the search and not be changed mid-search
+    void setNetwork(const ChessNetwork *network);
+    const ChessNetwork *network() const { return _network; }
+
+    // probe these endgame tables at the root and at any node with at least probeDepth plies
+    // left and no more than pieceLimit pieces, nullptr to stop. same lifetime rules as the network
+    void setTablebase(const ChessTablebase *tablebase, int probeDepth, int pieceLimit);
+    const ChessTablebase *tablebase() const { return _tablebase; }
+
+    // called after each completed iteration, the default prints formatReport() to std::cout
+    void setReporter(std::function<void(const SearchReport &)> reporter) { _reporter = reporter; }
+    const SearchReport &lastReport() const { return _report; }
+
+    // pawn hash use over the last search, summed over all threads, for profiling
+    void pawnTableStats(uint64_t &hits, uint64_t &probes) const;
+
+private:
+    // helper threads share the table and the stop flag of the searcher that owns them
+    ChessSearch(TranspositionTable &tt, std::atomic<bool> *stopFlag);
+
+    void helperSearch(int startDepth);
+    uint64_t totalNodes() const;
+    uint64_t totalTbHits() const;
+    // a root in the tables is answered from them without searching
+    bool rootTablebaseMove(BitMove &move);
+    // only the owning thread writes its counter, the others just read it
+    uint64_t countNode()
+    {
+        uint64_t nodes = _nodes.load(std::memory_order_relaxed) + 1;
+        _nodes.store(nodes, std::memory_order_relaxed);
+        return nodes;
+    }
+    bool stopped() const { return _stopFlag->load(std::memory_order_relaxed); }
+
+    int  negamax(int depth, int ply, int alpha, int beta, bool pvNode);
+    int  quiescence(int ply, int alpha, int beta);
+    void resetOrdering();
+    void updateQuietStats(int ply, int depth, const BitMove &move, const BitMove *tried, int triedCount);
+    bool timeUp();
+    // time counted against the limits: since the start, or since the ponder hit
+    int64_t budgetMs() const { return elapsedMs() - _budgetStartMs.load(std::memory_order_relaxed); }
+    // static evaluation of _pos, which is ply moves from the root
+    int  staticEval(int ply);
+    // a move was made at ply - 1: the accumulator for ply is only worked out if it gets evaluated
+    void pushAccumulator(int ply, const ChessUndo &undo)
+    {
+        if (!_network) return;
+        NNUEAccumulator &accumulator = _accumulators[ply];
+        accumulator.computed = false;
+        accumulator.dirtyCount = undo.dirtyCount;
+        for (int i = 0; i < undo.dirtyCount; i++) accumulator.dirty[i] = undo.dirty[i];
+    }
+    int64_t elapsedMs() const;
+
+    TranspositionTable &_tt;
+    ChessPosition       _pos;
+    SearchLimits        _limits;
+    std::atomic<bool>   _stop;
+    std::atomic<bool>  *_stopFlag;      // &_stop, or the owner's for a helper
+    std::atomic<uint64_t> _nodes;
+    std::atomic<bool>   _pondering;
+    std::atomic<int64_t> _budgetStartMs;
+    int                 _seldepth;
+    std::chrono::steady_clock::time_point _start;
+
+    // keys of the positions before each ply: the game's since the last capture or pawn move,
+    // then one per move down the tree. the halfmove clock stops at 255, older ones cannot repeat
+    static const int GameKeys = 256;
+    uint64_t _keys[GameKeys + MAX_PLY + 1];
+    int      _gameKeyCount;
+
+    BitMove _pv[MAX_PLY + 1][MAX_PLY + 1];
+    int     _pvLength[MAX_PLY + 1];
+
+    // move ordering state, per thread
+    BitMove      _killers[MAX_PLY + 1][2];
+    ChessHistory _history;
+
+    ChessPawnTable _pawnTable;     // per thread, keeps its entries from one search to the next
+
+    const ChessNetwork          *_network;
+    std::vector<NNUEAccumulator> _accumulators;    // one per ply, used with a network only
+
+    const ChessTablebase *_tablebase;
+    int                   _tbProbeDepth;
+    int                   _tbPieceLimit;
+    std::atomic<uint64_t> _tbHits;
+
+    SearchReport _report;
+    std::function<void(const SearchReport &)> _reporter;
+
+    std::vector<std::unique_ptr<ChessSearch>> _helpers;
+};
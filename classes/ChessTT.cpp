@@ -0,0 +1,142 @@
+#include "ChessTT.h"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <xmmintrin.h>
+#endif
+
+//
+// data word layout
+//   bits  0..31  move (from, to, piece, flags)
+//   bits 32..47  score (int16)
+//   bits 48..55  depth (int8)
+//   bits 56..57  bound
+//   bits 58..63  generation
+//
+
+TranspositionTable::TranspositionTable(size_t megabytes)
+    : _mask(0), _generation(0)
+{
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+    size_t bytes = (megabytes ? megabytes : 1) * 1024 * 1024;
+    size_t count = 1;
+    while (count * 2 * sizeof(Bucket) <= bytes) count *= 2;
+
+    std::vector<Bucket> buckets(count);
+    _buckets.swap(buckets);
+    _mask = count - 1;
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    for (Bucket &bucket : _buckets) {
+        for (Entry &entry : bucket.entries) {
+            entry.check.store(0, std::memory_order_relaxed);
+            entry.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    _generation = 0;
+}
+
+uint64_t TranspositionTable::pack(const BitMove &move, int score, int depth, TTBound bound, uint8_t generation)
+{
+    uint64_t moveBits = (uint64_t)move.from | ((uint64_t)move.to << 8) |
+                        ((uint64_t)move.piece << 16) | ((uint64_t)move.flags << 24);
+    return moveBits |
+           ((uint64_t)(uint16_t)(int16_t)score << 32) |
+           ((uint64_t)(uint8_t)(int8_t)depth << 48) |
+           ((uint64_t)(bound & 3) << 56) |
+           ((uint64_t)(generation & 0x3F) << 58);
+}
+
+void TranspositionTable::unpack(uint64_t data, TTData &out)
+{
+    out.move = BitMove((int)(data & 0xFF), (int)((data >> 8) & 0xFF),
+                       (uint8_t)((data >> 16) & 0xFF), (uint8_t)((data >> 24) & 0xFF));
+    out.score = (int16_t)((data >> 32) & 0xFFFF);
+    out.depth = depthOf(data);
+    out.bound = (TTBound)((data >> 56) & 3);
+}
+
+bool TranspositionTable::probe(uint64_t key, TTData &out) const
+{
+    const Bucket &bucket = bucketFor(key);
+    for (const Entry &entry : bucket.entries) {
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+        if (data && (check ^ data) == key) {
+            unpack(data, out);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, const BitMove &move, int score, int depth, TTBound bound)
+{
+    Bucket &bucket = bucketFor(key);
+    Entry *replace = nullptr;
+    int worst = 1 << 30;
+
+    for (Entry &entry : bucket.entries) {
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+
+        if (!data || (check ^ data) == key) {
+            // same position: keep a deeper result unless the new one is exact,
+            // and keep the old best move if the new search did not find one
+            if (data && bound != BoundExact && depth + 2 < depthOf(data) &&
+                generationOf(data) == _generation) {
+                return;
+            }
+            BitMove keep = move;
+            if (data && keep.from == keep.to) {
+                TTData old;
+                unpack(data, old);
+                keep = old.move;
+            }
+            uint64_t packed = pack(keep, score, depth, bound, _generation);
+            entry.data.store(packed, std::memory_order_relaxed);
+            entry.check.store(key ^ packed, std::memory_order_relaxed);
+            return;
+        }
+
+        // depth preferred, with entries from older searches counted as shallower
+        int age = (_generation - generationOf(data)) & 0x3F;
+        int value = depthOf(data) - 8 * age;
+        if (value < worst) {
+            worst = value;
+            replace = &entry;
+        }
+    }
+
+    uint64_t packed = pack(move, score, depth, bound, _generation);
+    replace->data.store(packed, std::memory_order_relaxed);
+    replace->check.store(key ^ packed, std::memory_order_relaxed);
+}
+
+void TranspositionTable::prefetch(uint64_t key) const
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    _mm_prefetch((const char *)&bucketFor(key), _MM_HINT_T0);
+#else
+    __builtin_prefetch(&bucketFor(key));
+#endif
+}
+
+int TranspositionTable::hashfull() const
+{
+    int used = 0;
+    size_t samples = _buckets.size() < 250 ? _buckets.size() : 250;
+    for (size_t i = 0; i < samples; i++) {
+        for (const Entry &entry : _buckets[i].entries) {
+            uint64_t data = entry.data.load(std::memory_order_relaxed);
+            if (data && generationOf(data) == _generation) used++;
+        }
+    }
+    return samples ? (int)(used * 1000 / (samples * 4)) : 0;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "bitboard.h"
+
+enum TTBound : uint8_t
+{
+    BoundNone  = 0,
+    BoundUpper = 1,     // fail low, score is at most this
+    BoundLower = 2,     // fail high, score is at least this
+    BoundExact = 3
+};
+
+// what a probe hands back to the search
+struct TTData
+{
+    BitMove move;
+    int     score;
+    int     depth;
+    TTBound bound;
+};
+
+//
+// fixed size transposition table shared by every search thread
+//
+// entries are two 64-bit words: the packed data and (key ^ data). a reader accepts an entry
+// only if the two words xor back to its own key, so an entry torn by a concurrent writer
+// simply reads as a miss and no locks are needed. four entries make one 64-byte bucket,
+// so a probe touches a single cache line.
+//
+class TranspositionTable
+{
+public:
+    explicit TranspositionTable(size_t megabytes = 16);
+
+    // reallocates and clears, the bucket count is rounded down to a power of two
+    void   resize(size_t megabytes);
+    void   clear();
+    size_t sizeMB() const { return _buckets.size() * sizeof(Bucket) / (1024 * 1024); }
+
+    // call once per root search so older entries age out first
+    void   newSearch() { _generation = (uint8_t)((_generation + 1) & 0x3F); }
+
+    bool   probe(uint64_t key, TTData &out) const;
+    void   store(uint64_t key, const BitMove &move, int score, int depth, TTBound bound);
+    void   prefetch(uint64_t key) const;
+
+    // permille of sampled entries written during the current search, as UCI reports it
+    int    hashfull() const;
+
+private:
+    struct Entry
+    {
+        std::atomic<uint64_t> check;   // key ^ data
+        std::atomic<uint64_t> data;
+    };
+
+    struct alignas(64) Bucket
+    {
+        Entry entries[4];
+    };
+
+    static uint64_t pack(const BitMove &move, int score, int depth, TTBound bound, uint8_t generation);
+    static void     unpack(uint64_t data, TTData &out);
+    static int      depthOf(uint64_t data) { return (int8_t)((data >> 48) & 0xFF); }
+    static uint8_t  generationOf(uint64_t data) { return (uint8_t)(data >> 58); }
+
+    Bucket &bucketFor(uint64_t key) { return _buckets[key & _mask]; }
+    const Bucket &bucketFor(uint64_t key) const { return _buckets[key & _mask]; }
+
+    std::vector<Bucket> _buckets;
+    uint64_t            _mask;
+    uint8_t             _generation;
+};
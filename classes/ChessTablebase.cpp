@@ -0,0 +1,360 @@
+#include "ChessTablebase.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+//
+// table file
+//
+//   char[4]  "GFTB"
+//   uint8    version (1)
+//   uint8    0 = WDL, 1 = DTZ
+//   uint8    piece count
+//   uint8    unused
+//   char[8]  signature, zero padded
+//   uint8    values[2 * 64^count]
+//
+// index = sideToMove * 64^count + square of piece 0 * 64^(count-1) + ... + square of the last piece,
+// with pieces in signature order, identical pieces on ascending squares and colours as the
+// signature names them (the first side plays white).
+//
+static const char  TableMagic[4] = { 'G', 'F', 'T', 'B' };
+static const uint8_t TableVersion = 1;
+static const size_t HeaderSize = 16;
+
+static const char PieceLetters[] = " PNBRQK";
+
+// ===========================================================
+// Signatures and layout
+// ===========================================================
+
+// "KRP" for a king, rook and pawn: king first, then from the queen down
+static std::string sideString(const ChessPosition &position, int player)
+{
+    std::string side = "K";
+    for (int piece = Queen; piece >= Pawn; piece--) {
+        side.append(popCount(position.pieces(player, (ChessPiece)piece)), PieceLetters[piece]);
+    }
+    return side;
+}
+
+// the side with more material is written first, so KvKQ uses the KQvK table
+static bool strongerSide(const std::string &a, const std::string &b)
+{
+    auto value = [](const std::string &side) {
+        int total = 0;
+        for (char c : side) {
+            switch (c) {
+                case 'Q': total += 9; break;
+                case 'R': total += 5; break;
+                case 'B': case 'N': total += 3; break;
+                case 'P': total += 1; break;
+            }
+        }
+        return total;
+    };
+    if (value(a) != value(b)) return value(a) > value(b);
+    if (a.size() != b.size()) return a.size() > b.size();
+    // same value and count: the first difference in KQRBNP order decides
+    static const std::string order = "KQRBNP";
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i] != b[i]) return order.find(a[i]) < order.find(b[i]);
+    }
+    return true;
+}
+
+std::string ChessTablebase::signatureOf(const ChessPosition &position, bool &flip)
+{
+    std::string white = sideString(position, WHITE);
+    std::string black = sideString(position, BLACK);
+    flip = !strongerSide(white, black);
+    return flip ? black + "v" + white : white + "v" + black;
+}
+
+bool ChessTablebase::layoutFor(const std::string &signature, TablebaseLayout &layout)
+{
+    size_t split = signature.find('v');
+    if (split == std::string::npos || split == 0 || signature[0] != 'K' || split + 1 >= signature.size() ||
+        signature[split + 1] != 'K') {
+        return false;
+    }
+
+    layout.signature = signature;
+    layout.count = 0;
+    for (size_t i = 0; i < signature.size(); i++) {
+        if (i == split) continue;
+        const char *letter = std::strchr(PieceLetters + 1, signature[i]);
+        if (!letter || layout.count == TablebaseLayout::MaxPieces) return false;
+        // only the leading K of each side may be a king
+        int piece = (int)(letter - PieceLetters);
+        bool leading = i == 0 || i == split + 1;
+        if ((piece == King) != leading) return false;
+        layout.player[layout.count] = i < split ? WHITE : BLACK;
+        layout.piece[layout.count] = (uint8_t)piece;
+        layout.count++;
+    }
+    return true;
+}
+
+uint64_t ChessTablebase::composeIndex(int sideToMove, int *squares, const TablebaseLayout &layout)
+{
+    uint64_t index = (uint64_t)sideToMove;
+    int start = 0;
+    for (int i = 0; i < layout.count; i++) {
+        // sort each run of identical pieces as it ends
+        bool runEnds = i + 1 == layout.count || layout.piece[i + 1] != layout.piece[i] ||
+                       layout.player[i + 1] != layout.player[i];
+        if (runEnds) {
+            std::sort(squares + start, squares + i + 1);
+            start = i + 1;
+        }
+    }
+    for (int i = 0; i < layout.count; i++) index = (index << 6) | (uint64_t)squares[i];
+    return index;
+}
+
+uint64_t ChessTablebase::indexOf(const ChessPosition &position, const TablebaseLayout &layout, bool flip)
+{
+    int squares[TablebaseLayout::MaxPieces];
+    for (int i = 0; i < layout.count; i++) {
+        // identical pieces share one bitboard, taken once at the start of their run
+        if (i > 0 && layout.piece[i] == layout.piece[i - 1] && layout.player[i] == layout.player[i - 1]) continue;
+        // the table's white is black on this board when flipped, and the board is mirrored to match
+        int player = flip ? layout.player[i] ^ 1 : layout.player[i];
+        uint64_t bb = position.pieces(player, (ChessPiece)layout.piece[i]);
+        for (int j = i; j < layout.count && bb; j++) {
+            int square = popLsb(bb);
+            squares[j] = flip ? square ^ 56 : square;
+        }
+    }
+    int sideToMove = flip ? position.sideToMove() ^ 1 : position.sideToMove();
+    return composeIndex(sideToMove, squares, layout);
+}
+
+bool ChessTablebase::positionAt(uint64_t index, const TablebaseLayout &layout, ChessPosition &position)
+{
+    int squares[TablebaseLayout::MaxPieces];
+    uint64_t occupied = 0ULL;
+    for (int i = layout.count - 1; i >= 0; i--) {
+        squares[i] = (int)(index & 63);
+        index >>= 6;
+    }
+    int sideToMove = (int)index;
+
+    for (int i = 0; i < layout.count; i++) {
+        uint64_t bit = 1ULL << squares[i];
+        if (occupied & bit) return false;
+        occupied |= bit;
+        if (layout.piece[i] == Pawn && (squares[i] < 8 || squares[i] >= 56)) return false;
+        if (i > 0 && layout.piece[i] == layout.piece[i - 1] && layout.player[i] == layout.player[i - 1] &&
+            squares[i] < squares[i - 1]) {
+            return false;
+        }
+    }
+
+    position.clear();
+    for (int i = 0; i < layout.count; i++) position.putPiece(layout.player[i], (ChessPiece)layout.piece[i], squares[i]);
+    position.setSideToMove(sideToMove);
+    // the side that just moved cannot have left its king in check
+    return !position.isSquareAttacked(position.kingSquare(sideToMove ^ 1), sideToMove);
+}
+
+// ===========================================================
+// Files
+// ===========================================================
+
+std::string ChessTablebase::fileName(const std::string &directory, const std::string &signature, bool dtz)
+{
+    std::string name = directory;
+    if (!name.empty() && name.back() != '/' && name.back() != '\\') name += '/';
+    return name + signature + (dtz ? ".dtz" : ".wdl");
+}
+
+bool ChessTablebase::writeTable(const std::string &directory, const TablebaseLayout &layout, bool dtz,
+                                const std::vector<uint8_t> &values)
+{
+    if (values.size() != layout.size()) return false;
+    std::ofstream out(fileName(directory, layout.signature, dtz), std::ios::binary);
+    if (!out) return false;
+
+    char header[HeaderSize] = {};
+    std::memcpy(header, TableMagic, 4);
+    header[4] = (char)TableVersion;
+    header[5] = dtz ? 1 : 0;
+    header[6] = (char)layout.count;
+    std::memcpy(header + 8, layout.signature.data(), std::min<size_t>(8, layout.signature.size()));
+    out.write(header, HeaderSize);
+    out.write((const char *)values.data(), (std::streamsize)values.size());
+    return (bool)out;
+}
+
+void ChessTablebase::setPath(const std::string &directory)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (Slot &slot : _slots) slot.table.store(nullptr, std::memory_order_relaxed);
+    _tables.clear();
+    _path = directory;
+}
+
+static_assert(TablebaseLayout::MaxPieces - 2 == 3, "material slots hold three pieces besides the kings");
+
+int ChessTablebase::materialKey(const ChessPosition &position)
+{
+    int key = 0, pieces = 0;
+    for (int player = WHITE; player <= BLACK; player++) {
+        for (int piece = Pawn; piece <= Queen; piece++) {
+            int count = popCount(position.pieces(player, (ChessPiece)piece));
+            pieces += count;
+            if (pieces > TablebaseLayout::MaxPieces - 2) return -1;
+            int code = 1 + 5 * (player == WHITE ? 0 : 1) + (piece - Pawn);
+            while (count--) key = key * 11 + code;
+        }
+    }
+    return key;
+}
+
+ChessTablebase::Table *ChessTablebase::tableFor(const ChessPosition &position, int key, bool &flip) const
+{
+    Slot &slot = _slots[key];
+    if (Table *table = slot.table.load(std::memory_order_acquire)) {
+        flip = slot.flip;
+        return table;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::string signature = signatureOf(position, flip);
+    // both colourings of a material share the table, and its files
+    std::unique_ptr<Table> &table = _tables[signature];
+    if (!table) {
+        table.reset(new Table());
+        if (!layoutFor(signature, table->layout)) {
+            table->state[0].store(FileMissing, std::memory_order_relaxed);
+            table->state[1].store(FileMissing, std::memory_order_relaxed);
+        }
+    }
+    slot.flip = flip;
+    slot.table.store(table.get(), std::memory_order_release);
+    return table.get();
+}
+
+const uint8_t *ChessTablebase::values(Table &table, bool dtz) const
+{
+    std::atomic<FileState> &state = table.state[dtz ? 1 : 0];
+    MappedFile &file = table.files[dtz ? 1 : 0];
+    FileState seen = state.load(std::memory_order_acquire);
+    if (seen == FileUntried) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        seen = state.load(std::memory_order_relaxed);
+        if (seen == FileUntried) {
+            // a missing or mismatched file is remembered as missing, it is not looked for again
+            const std::string &signature = table.layout.signature;
+            if (file.open(fileName(_path, signature, dtz))) {
+                const unsigned char *header = file.data();
+                bool valid = file.size() == HeaderSize + table.layout.size() &&
+                             std::memcmp(header, TableMagic, 4) == 0 && header[4] == TableVersion &&
+                             header[5] == (dtz ? 1 : 0) && header[6] == table.layout.count &&
+                             std::strncmp((const char *)header + 8, signature.c_str(), 8) == 0;
+                if (!valid) file.close();
+            }
+            seen = file.isOpen() ? FileMapped : FileMissing;
+            state.store(seen, std::memory_order_release);
+        }
+    }
+    return seen == FileMapped ? file.data() + HeaderSize : nullptr;
+}
+
+// ===========================================================
+// Probing
+// ===========================================================
+
+bool ChessTablebase::probeable(const ChessPosition &position, int pieceLimit)
+{
+    int limit = std::min(pieceLimit, TablebaseLayout::MaxPieces);
+    return popCount(position.occupancy()) <= limit && position.castlingRights() == 0 &&
+           position.enPassantSquare() < 0;
+}
+
+bool ChessTablebase::probe(const ChessPosition &position, bool dtz, uint8_t &value) const
+{
+    if (!enabled()) return false;
+
+    int key = materialKey(position);
+    if (key < 0) return false;
+    // bare kings are a draw without any table
+    if (key == 0) {
+        value = dtz ? 0 : TBDraw;
+        return true;
+    }
+
+    bool flip;
+    Table *table = tableFor(position, key, flip);
+    const uint8_t *data = values(*table, dtz);
+    if (!data) return false;
+    value = data[indexOf(position, table->layout, flip)];
+    return true;
+}
+
+bool ChessTablebase::probeWDL(const ChessPosition &position, TBValue &value) const
+{
+    uint8_t stored;
+    if (!probe(position, false, stored) || stored > TBWin) return false;
+    value = (TBValue)stored;
+    return true;
+}
+
+bool ChessTablebase::probeDTZ(const ChessPosition &position, TBValue &value, int &dtz) const
+{
+    uint8_t stored;
+    if (!probeWDL(position, value) || !probe(position, true, stored)) return false;
+    dtz = stored;
+    return true;
+}
+
+// after a double push, whether the capture the tables know nothing about can be made
+static bool enPassantLegal(const ChessPosition &position)
+{
+    if (position.enPassantSquare() < 0) return false;
+    BitMove moves[MAX_CHESS_MOVES];
+    int count = position.generateLegalMoves(moves);
+    for (int i = 0; i < count; i++) {
+        if (moves[i].flags & BitMove::EnPassant) return true;
+    }
+    return false;
+}
+
+bool ChessTablebase::probeRoot(const ChessPosition &position, BitMove &move, TBValue &value, int &dtz) const
+{
+    BitMove moves[MAX_CHESS_MOVES];
+    int count = position.generateLegalMoves(moves);
+    if (count == 0) return false;
+
+    int bestValue = -1, bestDtz = 0;
+    ChessPosition child = position;
+    for (int i = 0; i < count; i++) {
+        ChessUndo undo;
+        child.makeMove(moves[i], undo);
+        TBValue childValue;
+        int childDtz;
+        bool found = !enPassantLegal(child) && probeDTZ(child, childValue, childDtz);
+        child.unmakeMove(moves[i], undo);
+        if (!found) return false;
+
+        // captures and pawn moves start the count again
+        bool zeroing = moves[i].isCapture() || moves[i].piece == Pawn;
+        int ourValue = TBWin - childValue;
+        int ourDtz = zeroing ? 1 : childDtz + 1;
+
+        bool better = ourValue > bestValue ||
+                      (ourValue == bestValue && ourValue == TBWin && ourDtz < bestDtz) ||
+                      (ourValue == bestValue && ourValue == TBLoss && ourDtz > bestDtz);
+        if (better) {
+            bestValue = ourValue;
+            bestDtz = ourDtz;
+            move = moves[i];
+        }
+    }
+
+    value = (TBValue)bestValue;
+    dtz = bestValue == TBDraw ? 0 : bestDtz;
+    return true;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ChessPosition.h"
+#include "MappedFile.h"
+
+// game theoretic value for the side to move, as stored in a WDL table
+enum TBValue : uint8_t
+{
+    TBLoss    = 0,
+    TBDraw    = 1,
+    TBWin     = 2,
+    TBInvalid = 3       // not a legal position
+};
+
+// what each digit of a table index stands for
+struct TablebaseLayout
+{
+    static const int MaxPieces = 5;
+    // no symmetry is folded out of the index, so a 5-piece table is 2 GiB a file. probing and
+    // generation stop at 4 unless 5 is asked for
+    static const int DefaultPieces = 4;
+
+    std::string signature;              // e.g. "KRPvKR": the first side's pieces, 'v', the second's
+    int         count;                  // pieces, kings included
+    uint8_t     player[MaxPieces];      // table colours, WHITE is the side written first
+    uint8_t     piece[MaxPieces];       // ChessPiece
+
+    // side to move times one square per piece
+    uint64_t size() const { return 2ULL << (6 * count); }
+};
+
+//
+// endgame tablebases, one pair of files per material signature
+//
+//   <signature>.wdl   win / draw / loss for every placement, one byte each
+//   <signature>.dtz   plies to the next capture, pawn move or mate with best play
+//
+// the files are our own uncompressed format (see ChessTablebase.cpp), produced offline
+// by the tbgen tool; they are not Syzygy files. they are memory mapped the first time
+// a position with that material is probed, so only tables actually used are opened.
+// after that a probe finds its table by material key and reads it without locking.
+//
+// the tables ignore the fifty-move rule and en passant, so positions with castling
+// rights or an en passant square are never probed.
+//
+class ChessTablebase
+{
+public:
+    // directory holding the tables, closes everything opened so far. empty turns probing off.
+    // not to be called while a search is probing
+    void setPath(const std::string &directory);
+    const std::string &path() const { return _path; }
+    bool enabled() const { return !_path.empty(); }
+
+    // few enough pieces, no castling rights and no en passant capture pending
+    static bool probeable(const ChessPosition &position, int pieceLimit);
+
+    // false when there is no table for this material. safe to call from several threads
+    bool probeWDL(const ChessPosition &position, TBValue &value) const;
+    bool probeDTZ(const ChessPosition &position, TBValue &value, int &dtz) const;
+    // the move that keeps the best result: the shortest way to the next zeroing move when
+    // winning, the longest when losing. needs the DTZ tables of the position's children, and
+    // fails when a move lets the opponent take en passant, which the tables leave out
+    bool probeRoot(const ChessPosition &position, BitMove &move, TBValue &value, int &dtz) const;
+
+    // the table layout, shared with the generator
+
+    // canonical signature, flip is set when the table's first side is black here
+    static std::string signatureOf(const ChessPosition &position, bool &flip);
+    static bool layoutFor(const std::string &signature, TablebaseLayout &layout);
+    // sorts the squares of identical pieces, so each placement has a single index
+    static uint64_t composeIndex(int sideToMove, int *squares, const TablebaseLayout &layout);
+    static uint64_t indexOf(const ChessPosition &position, const TablebaseLayout &layout, bool flip);
+    // false for placements that are not a legal position or not the canonical index
+    static bool positionAt(uint64_t index, const TablebaseLayout &layout, ChessPosition &position);
+    static std::string fileName(const std::string &directory, const std::string &signature, bool dtz);
+    static bool writeTable(const std::string &directory, const TablebaseLayout &layout, bool dtz,
+                           const std::vector<uint8_t> &values);
+
+private:
+    // a file is looked for once: mapped, or remembered as missing
+    enum FileState { FileUntried, FileMapped, FileMissing };
+
+    struct Table
+    {
+        TablebaseLayout        layout;
+        MappedFile             files[2];       // wdl, dtz
+        std::atomic<FileState> state[2] = { FileUntried, FileUntried };
+    };
+
+    // one slot per material: up to three pieces besides the kings, each a code from 1 to 10
+    // (colour and kind), sorted and read as base-11 digits. 0 is bare kings
+    static const int MaterialSlots = 11 * 11 * 11;
+    struct Slot
+    {
+        std::atomic<Table *> table { nullptr };  // published once, flip is set before
+        bool                 flip = false;
+    };
+
+    // the material slot of a position, -1 with too many pieces for any table
+    static int materialKey(const ChessPosition &position);
+    // the table for the slot's material, set up under the lock the first time
+    Table *tableFor(const ChessPosition &position, int key, bool &flip) const;
+    // the mapped values of a table, opened under the lock the first time. nullptr when missing
+    const uint8_t *values(Table &table, bool dtz) const;
+    bool probe(const ChessPosition &position, bool dtz, uint8_t &value) const;
+
+    std::string _path;
+    // only taken to set up a table or open a file, never on a probe that finds them
+    mutable std::mutex _mutex;
+    mutable std::unordered_map<std::string, std::unique_ptr<Table>> _tables;
+    mutable Slot _slots[MaterialSlots];
+};
@@ -16,6 +16,11 @@ Game::Game()
 	_gameOptions.rowY = 0;
 	_gameOptions.score = 0;
 	_gameOptions.AIDepthSearches = 0;
+	_gameOptions.AIMAXDepth = 0;
+	_gameOptions.AITimeBudgetMs = 0;
+	_gameOptions.AIThreads = 1;
+	_gameOptions.AIUseNetwork = false;
+	_gameOptions.AIPonder = false;
 	_gameOptions.AIvsAI = false;
 
 	_table = nullptr;
@@ -245,6 +250,27 @@ bool Game::gameHasAI()
 
 void Game::updateAI()
 {
+	if (!_aiWorker.valid())
+	{
+		_aiWorker = std::async(std::launch::async, [this]() { return searchAIMove(); });
+		return;
+	}
+	if (_aiWorker.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		return;
+	}
+	applyAIMove(_aiWorker.get());
+}
+
+void Game::stopAIWorker()
+{
+	if (!_aiWorker.valid())
+	{
+		return;
+	}
+	cancelAISearch();
+	_aiWorker.wait();
+	_aiWorker = std::future<int>();
 }
 
 void Game::mouseDown(ImVec2 &location, Entity *entity)
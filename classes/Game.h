@@ -41,6 +41,10 @@ struct GameOptions
 	int score;
 	int AIDepthSearches;
 	int AIMAXDepth;
+	int AITimeBudgetMs;
+	int AIThreads;
+	bool AIUseNetwork;
+	bool AIPonder;
 	bool AIvsAI;
 };
 
@@ -94,7 +98,23 @@ public:
 
 	virtual void stopGame() = 0;
 	virtual bool gameHasAI();
+	// called every frame while the AI is to move. the default runs searchAIMove() on a
+	// worker thread and, once it has finished, passes its result to applyAIMove() here
 	virtual void updateAI();
+	// worker thread: choose a move from the current state without touching the Grid or any Bit.
+	// the state cannot change underneath it, mouse input is ignored while the AI is to move
+	virtual int searchAIMove() { return -1; }
+	// main thread: play the move searchAIMove() returned through the usual move paths
+	virtual void applyAIMove(int move) {}
+	// ask a running searchAIMove() to return as soon as it can
+	virtual void cancelAISearch() {}
+	// called every frame while the human is to move and AIPonder is set. games that can
+	// search the expected reply in the meantime start that here, on the same worker
+	virtual void updatePonder() {}
+	bool aiThinking() const { return _aiWorker.valid(); }
+	// cancel any running search and wait for it, the move it found is dropped.
+	// games call this before tearing down state that searchAIMove() reads
+	void stopAIWorker();
 	virtual void pieceTaken(Bit *bit){};
 
 	virtual std::string initialStateString() = 0;
@@ -151,4 +171,6 @@ protected:
 	BitHolder *_dropTarget;
 	BitHolder *_oldHolder;
 	bool _dragMoved;
+
+	std::future<int> _aiWorker;
 };
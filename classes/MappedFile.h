@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+//
+// read-only memory mapping of a whole file, unmapped when closed or destroyed.
+// nothing is read up front, the OS pages the file in as it is touched.
+//
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // false if the file is missing, empty or cannot be mapped
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const { return _data != nullptr; }
+
+    const unsigned char *data() const { return _data; }
+    size_t size() const { return _size; }
+
+private:
+    const unsigned char *_data;
+    size_t               _size;
+#if defined(_WIN32)
+    void                *_file;
+    void                *_mapping;
+#endif
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include "Game.h"
-#include <vector>
+#include "OthelloBoard.h"
+#include "OthelloSearch.h"
 
 // NOTE: This implementation assumes black.png and white.png exist in resources.
 // If not, you can use o.png and x.png, or any other suitable graphics.
@@ -24,37 +25,41 @@ public:
     void        stopGame() override;
 
     // AI methods
-    void        updateAI() override;
     bool        gameHasAI() override { return true; } // Set to true when AI is implemented
+    void        updateAI() override;
+    int         searchAIMove() override;
+    void        applyAIMove(int move) override;
+    void        cancelAISearch() override { _search.stop(); }
     Grid* getGrid() override { return _grid; }
 
 private:
     // Player constants
-    static const int BLACK_PLAYER = 0;
-    static const int WHITE_PLAYER = 1;
-
-    // Direction vectors for checking all 8 directions
-    static const int DIRECTIONS[8][2];
+    static const int BLACK_PLAYER = OthelloBoard::BlackPlayer;
+    static const int WHITE_PLAYER = OthelloBoard::WhitePlayer;
 
     // Helper methods
     Bit*        createPiece(Player* player);
-    bool        isValidMove(int x, int y, Player* player) const;
-    int         checkDirection(int x, int y, int dx, int dy, Player* player) const;
-    void        flipPieces(int x, int y, Player* player);
-    void        flipInDirection(int x, int y, int dx, int dy, Player* player, int count);
-    bool        hasValidMove(Player* player) const;
-    void        countPieces(int &blackCount, int &whiteCount) const;
-    std::vector<std::pair<int, int>> getValidMoves(Player* player) const;
+    // search limits from the AI options, main thread only
+    OthelloSearchLimits aiLimits();
+    // rebuild the sprites of any square that no longer matches _board
+    void        syncGridToBoard();
     void        showValidMoves(Player* player);
     void        clearValidMoveIndicators();
 
     // Board position helper
     void        getBoardPosition(BitHolder& holder, int &x, int &y) const;
 
-    // Board representation
+    // Board representation: the rules work on _board, the grid only mirrors it
+    OthelloBoard _board;
     Grid*       _grid;
 
+    // alpha-beta search run by the AI worker, its table is kept from move to move
+    OthelloSearch _search;
+    // pattern weights from resources/othello_patterns.bin, the search uses them when loaded
+    OthelloPatterns _patterns;
+    // limits for the search searchAIMove() runs, set before the worker starts
+    OthelloSearchLimits _aiLimits;
+
     // Game state
-    int         _consecutivePasses;
     bool        _showingHints;
 };
\ No newline at end of file
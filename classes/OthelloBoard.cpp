@@ -0,0 +1,330 @@
+#include "OthelloBoard.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define OTHELLO_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC lets any function use the intrinsics
+#define OTHELLO_TARGET_AVX2
+#else
+// only these functions are built for AVX2, the rest of the program runs on any x86-64
+#define OTHELLO_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// files b..g: a run along a row or diagonal that reached file a or h would wrap onto the next
+// row when shifted, so opponent discs there never take part in one in those directions
+static const uint64_t InnerFiles = 0x7E7E7E7E7E7E7E7EULL;
+
+// ===========================================================
+// Setup
+// ===========================================================
+
+void OthelloBoard::reset()
+{
+    _discs[BlackPlayer] = (1ULL << (3 * 8 + 4)) | (1ULL << (4 * 8 + 3));
+    _discs[WhitePlayer] = (1ULL << (3 * 8 + 3)) | (1ULL << (4 * 8 + 4));
+    _sideToMove = BlackPlayer;
+}
+
+bool OthelloBoard::setString(const std::string &state, int sideToMove)
+{
+    if (state.size() != 64) return false;
+    uint64_t discs[2] = { 0ULL, 0ULL };
+    for (int square = 0; square < 64; square++) {
+        switch (state[square]) {
+            case '0': break;
+            case '1': discs[BlackPlayer] |= 1ULL << square; break;
+            case '2': discs[WhitePlayer] |= 1ULL << square; break;
+            default: return false;
+        }
+    }
+    _discs[BlackPlayer] = discs[BlackPlayer];
+    _discs[WhitePlayer] = discs[WhitePlayer];
+    _sideToMove = sideToMove;
+    return true;
+}
+
+std::string OthelloBoard::toString() const
+{
+    std::string state(64, '0');
+    for (int square = 0; square < 64; square++) {
+        int owner = ownerOn(square);
+        if (owner >= 0) state[square] = owner == BlackPlayer ? '1' : '2';
+    }
+    return state;
+}
+
+int OthelloBoard::ownerOn(int square) const
+{
+    if ((_discs[BlackPlayer] >> square) & 1) return BlackPlayer;
+    if ((_discs[WhitePlayer] >> square) & 1) return WhitePlayer;
+    return -1;
+}
+
+// ===========================================================
+// Move generation and flips
+// ===========================================================
+
+// one step along a direction given as a square offset
+template <int Offset>
+static inline uint64_t shift(uint64_t bb)
+{
+    if constexpr (Offset > 0)
+        return bb << Offset;
+    else
+        return bb >> -Offset;
+}
+
+//
+// the opponent discs in an unbroken line from any of the starting squares, parallel prefix
+// style: after the first two steps every run of up to two is found, and each doubling step
+// through pairs of adjacent opponent discs adds two more, enough for the six a row can hold
+//
+template <int Offset>
+static inline uint64_t opponentRun(uint64_t from, uint64_t opponent)
+{
+    uint64_t run = opponent & shift<Offset>(from);
+    run |= opponent & shift<Offset>(run);
+    uint64_t pairs = opponent & shift<Offset>(opponent);
+    run |= pairs & shift<2 * Offset>(run);
+    run |= pairs & shift<2 * Offset>(run);
+    return run;
+}
+
+static uint64_t legalMovesScalar(uint64_t own, uint64_t opponent)
+{
+    // an empty square at the far end of a run that starts next to one of our discs
+    uint64_t empty = ~(own | opponent);
+    uint64_t inner = opponent & InnerFiles;
+    uint64_t moves = 0ULL;
+    moves |= shift<1>(opponentRun<1>(own, inner));
+    moves |= shift<-1>(opponentRun<-1>(own, inner));
+    moves |= shift<8>(opponentRun<8>(own, opponent));
+    moves |= shift<-8>(opponentRun<-8>(own, opponent));
+    moves |= shift<7>(opponentRun<7>(own, inner));
+    moves |= shift<-7>(opponentRun<-7>(own, inner));
+    moves |= shift<9>(opponentRun<9>(own, inner));
+    moves |= shift<-9>(opponentRun<-9>(own, inner));
+    return moves & empty;
+}
+
+// the run from the new disc turns only if one of our discs closes it
+template <int Offset>
+static inline uint64_t flipsInDirection(uint64_t move, uint64_t own, uint64_t opponent)
+{
+    uint64_t run = opponentRun<Offset>(move, opponent);
+    return (shift<Offset>(run) & own) ? run : 0ULL;
+}
+
+static uint64_t flipsScalar(int square, uint64_t own, uint64_t opponent)
+{
+    uint64_t move = 1ULL << square;
+    if ((own | opponent) & move) return 0ULL;
+    uint64_t inner = opponent & InnerFiles;
+    return flipsInDirection<1>(move, own, inner) | flipsInDirection<-1>(move, own, inner) |
+           flipsInDirection<8>(move, own, opponent) | flipsInDirection<-8>(move, own, opponent) |
+           flipsInDirection<7>(move, own, inner) | flipsInDirection<-7>(move, own, inner) |
+           flipsInDirection<9>(move, own, inner) | flipsInDirection<-9>(move, own, inner);
+}
+
+// ===========================================================
+// AVX2 kernels
+// ===========================================================
+
+#if defined(OTHELLO_X86)
+
+//
+// the same parallel prefix fills, one direction per 64-bit lane: the lanes step by 1, 8, 9
+// and 7 squares, one vector running left and one right, so all eight directions take a
+// single pass. the vertical lane keeps the opponent discs on files a and h
+//
+struct Avx2Lines
+{
+    __m256i mask;           // opponent discs usable in each lane's direction
+    __m256i pairsLeft;      // opponent discs with another one step back along the lane
+    __m256i pairsRight;
+    __m256i step;
+    __m256i doubleStep;
+};
+
+OTHELLO_TARGET_AVX2
+static inline Avx2Lines avx2Lines(uint64_t opponent)
+{
+    Avx2Lines lines;
+    lines.step = _mm256_set_epi64x(7, 9, 8, 1);
+    lines.doubleStep = _mm256_add_epi64(lines.step, lines.step);
+    lines.mask = _mm256_and_si256(_mm256_set1_epi64x((long long)opponent),
+                                  _mm256_set_epi64x((long long)InnerFiles, (long long)InnerFiles, -1LL,
+                                                    (long long)InnerFiles));
+    lines.pairsLeft = _mm256_and_si256(lines.mask, _mm256_sllv_epi64(lines.mask, lines.step));
+    lines.pairsRight = _mm256_srlv_epi64(lines.pairsLeft, lines.step);
+    return lines;
+}
+
+// the opponent runs from the starting squares, left and right, as opponentRun() does
+OTHELLO_TARGET_AVX2
+static inline void avx2Runs(const Avx2Lines &lines, __m256i from, __m256i &left, __m256i &right)
+{
+    left = _mm256_and_si256(lines.mask, _mm256_sllv_epi64(from, lines.step));
+    right = _mm256_and_si256(lines.mask, _mm256_srlv_epi64(from, lines.step));
+    left = _mm256_or_si256(left, _mm256_and_si256(lines.mask, _mm256_sllv_epi64(left, lines.step)));
+    right = _mm256_or_si256(right, _mm256_and_si256(lines.mask, _mm256_srlv_epi64(right, lines.step)));
+    left = _mm256_or_si256(left, _mm256_and_si256(lines.pairsLeft, _mm256_sllv_epi64(left, lines.doubleStep)));
+    right = _mm256_or_si256(right, _mm256_and_si256(lines.pairsRight, _mm256_srlv_epi64(right, lines.doubleStep)));
+    left = _mm256_or_si256(left, _mm256_and_si256(lines.pairsLeft, _mm256_sllv_epi64(left, lines.doubleStep)));
+    right = _mm256_or_si256(right, _mm256_and_si256(lines.pairsRight, _mm256_srlv_epi64(right, lines.doubleStep)));
+}
+
+OTHELLO_TARGET_AVX2
+static inline uint64_t avx2OrLanes(__m256i bits)
+{
+    __m128i half = _mm_or_si128(_mm256_castsi256_si128(bits), _mm256_extracti128_si256(bits, 1));
+    return (uint64_t)_mm_cvtsi128_si64(_mm_or_si128(half, _mm_unpackhi_epi64(half, half)));
+}
+
+OTHELLO_TARGET_AVX2
+static uint64_t legalMovesAVX2(uint64_t own, uint64_t opponent)
+{
+    Avx2Lines lines = avx2Lines(opponent);
+    __m256i left, right;
+    avx2Runs(lines, _mm256_set1_epi64x((long long)own), left, right);
+    __m256i moves = _mm256_or_si256(_mm256_sllv_epi64(left, lines.step), _mm256_srlv_epi64(right, lines.step));
+    return avx2OrLanes(moves) & ~(own | opponent);
+}
+
+OTHELLO_TARGET_AVX2
+static uint64_t flipsAVX2(int square, uint64_t own, uint64_t opponent)
+{
+    uint64_t move = 1ULL << square;
+    if ((own | opponent) & move) return 0ULL;
+
+    Avx2Lines lines = avx2Lines(opponent);
+    __m256i left, right;
+    avx2Runs(lines, _mm256_set1_epi64x((long long)move), left, right);
+
+    // a run turns only if one of our discs closes it
+    __m256i ownDiscs = _mm256_set1_epi64x((long long)own);
+    __m256i zero = _mm256_setzero_si256();
+    __m256i openLeft = _mm256_cmpeq_epi64(_mm256_and_si256(ownDiscs, _mm256_sllv_epi64(left, lines.step)), zero);
+    __m256i openRight = _mm256_cmpeq_epi64(_mm256_and_si256(ownDiscs, _mm256_srlv_epi64(right, lines.step)), zero);
+    __m256i flipped = _mm256_or_si256(_mm256_andnot_si256(openLeft, left), _mm256_andnot_si256(openRight, right));
+    return avx2OrLanes(flipped);
+}
+
+#endif
+
+// ===========================================================
+// Kernel selection
+// ===========================================================
+
+static bool cpuHasAVX2()
+{
+#if defined(OTHELLO_X86) && defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    // the OS has to save the ymm registers too
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(OTHELLO_X86)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+static OthelloBoard::Kernel defaultKernel()
+{
+    static const bool avx2 = cpuHasAVX2();
+    return avx2 ? OthelloBoard::KernelAVX2 : OthelloBoard::KernelScalar;
+}
+
+// the pointers start out on these, so a board used before the selection below still works
+static uint64_t legalMovesFirstCall(uint64_t own, uint64_t opponent)
+{
+    OthelloBoard::setKernel(defaultKernel());
+    return OthelloBoard::legalMoves(own, opponent);
+}
+
+static uint64_t flipsFirstCall(int square, uint64_t own, uint64_t opponent)
+{
+    OthelloBoard::setKernel(defaultKernel());
+    return OthelloBoard::flips(square, own, opponent);
+}
+
+uint64_t (*OthelloBoard::_legalMovesKernel)(uint64_t, uint64_t) = legalMovesFirstCall;
+uint64_t (*OthelloBoard::_flipsKernel)(int, uint64_t, uint64_t) = flipsFirstCall;
+
+// picks the kernels before main(), ahead of any search thread
+static const bool KernelSelected = OthelloBoard::setKernel(defaultKernel());
+
+bool OthelloBoard::kernelSupported(Kernel kernel)
+{
+    if (kernel == KernelScalar) return true;
+#if defined(OTHELLO_X86)
+    if (kernel == KernelAVX2) return defaultKernel() == KernelAVX2;
+#endif
+    return false;
+}
+
+bool OthelloBoard::setKernel(Kernel kernel)
+{
+    if (!kernelSupported(kernel)) return false;
+#if defined(OTHELLO_X86)
+    if (kernel == KernelAVX2) {
+        _legalMovesKernel = legalMovesAVX2;
+        _flipsKernel = flipsAVX2;
+        return true;
+    }
+#endif
+    _legalMovesKernel = legalMovesScalar;
+    _flipsKernel = flipsScalar;
+    return true;
+}
+
+OthelloBoard::Kernel OthelloBoard::kernel()
+{
+#if defined(OTHELLO_X86)
+    if (_legalMovesKernel == legalMovesAVX2) return KernelAVX2;
+#endif
+    return _legalMovesKernel == legalMovesScalar ? KernelScalar : defaultKernel();
+}
+
+const char *OthelloBoard::kernelName(Kernel kernel)
+{
+    return kernel == KernelAVX2 ? "AVX2" : "scalar";
+}
+
+// ===========================================================
+// Playing moves
+// ===========================================================
+
+uint64_t OthelloBoard::play(int square)
+{
+    int us = _sideToMove;
+    uint64_t flipped = flips(square, _discs[us], _discs[us ^ 1]);
+    if (!flipped) return 0ULL;
+
+    _discs[us] ^= flipped | (1ULL << square);
+    _discs[us ^ 1] ^= flipped;
+    _sideToMove = us ^ 1;
+    return flipped;
+}
+
+void OthelloBoard::undo(int square, uint64_t flipped)
+{
+    int us = _sideToMove ^ 1;
+    _discs[us] ^= flipped | (1ULL << square);
+    _discs[us ^ 1] ^= flipped;
+    _sideToMove = us;
+}
+
+bool OthelloBoard::gameOver() const
+{
+    return legalMoves(_discs[0], _discs[1]) == 0 && legalMoves(_discs[1], _discs[0]) == 0;
+}
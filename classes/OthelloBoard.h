@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "bitboard.h"
+
+//
+// two-bitboard Othello position
+//
+// squares are y * 8 + x, the order the Grid walks its squares and the AI reports moves in.
+// move generation and flips are shift-and-mask fills over all eight directions at once
+// (see OthelloBoard.cpp), so neither ever visits a square on its own. like ChessPosition
+// this is a plain value type, the Grid and its Bits only mirror it for display.
+//
+class OthelloBoard
+{
+public:
+    // player numbers as the Othello game uses them, black moves first
+    static const int BlackPlayer = 0;
+    static const int WhitePlayer = 1;
+
+    OthelloBoard() { reset(); }
+
+    // the four centre discs, black to move
+    void reset();
+    // 64 characters, '0' empty, '1' black, '2' white, in square order. false if malformed
+    bool setString(const std::string &state, int sideToMove);
+    std::string toString() const;
+
+    uint64_t discs(int player) const { return _discs[player]; }
+    uint64_t empty() const { return ~(_discs[BlackPlayer] | _discs[WhitePlayer]); }
+    int count(int player) const { return popCount(_discs[player]); }
+    int ownerOn(int square) const;   // -1 when the square is empty
+    int sideToMove() const { return _sideToMove; }
+    void setSideToMove(int player) { _sideToMove = player; }
+
+    // the kernels, on the discs of the player to move and of the opponent. they go through
+    // a pointer picked at startup: AVX2, four directions per vector, where the CPU has it,
+    // the portable scalar code otherwise
+    static uint64_t legalMoves(uint64_t own, uint64_t opponent) { return _legalMovesKernel(own, opponent); }
+    // the opponent discs a disc on square would turn, zero if the move is not legal
+    static uint64_t flips(int square, uint64_t own, uint64_t opponent) { return _flipsKernel(square, own, opponent); }
+
+    enum Kernel { KernelScalar, KernelAVX2 };
+    static bool kernelSupported(Kernel kernel);
+    // switches the kernels for every board, meant for benchmarks. false if the CPU cannot run it
+    static bool setKernel(Kernel kernel);
+    static Kernel kernel();
+    static const char *kernelName(Kernel kernel);
+
+    uint64_t legalMoves() const { return legalMoves(_discs[_sideToMove], _discs[_sideToMove ^ 1]); }
+    bool isLegal(int square) const { return (legalMoves() >> square) & 1; }
+
+    // place a disc for the side to move and hand the turn over. returns the discs turned,
+    // zero for an illegal square, which leaves the board as it was
+    uint64_t play(int square);
+    // take back play(square) given what it returned
+    void undo(int square, uint64_t flipped);
+    // the side to move has no legal move and the turn goes over without one
+    void pass() { _sideToMove ^= 1; }
+
+    bool mustPass() const { return legalMoves() == 0 && !gameOver(); }
+    // neither side can move, which includes a full board
+    bool gameOver() const;
+
+private:
+    static uint64_t (*_legalMovesKernel)(uint64_t own, uint64_t opponent);
+    static uint64_t (*_flipsKernel)(int square, uint64_t own, uint64_t opponent);
+
+    uint64_t _discs[2];
+    int      _sideToMove;
+};
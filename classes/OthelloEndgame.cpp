@@ -0,0 +1,386 @@
+#include "OthelloEndgame.h"
+
+static const int ScoreBelow = -65;     // below any disc difference
+static const int ScoreAbove = 65;
+static const int ShallowEmpties = 7;   // from here down: no table, no move sorting
+
+static const uint64_t Corners = 0x8100000000000081ULL;
+
+// the order the empty list is kept in: corners, the edges, the inner ring, C and X squares last
+static const int PresortedSquares[64] = {
+     0,  7, 56, 63,                             // corners
+     2,  5, 16, 23, 40, 47, 58, 61,             // A squares
+     3,  4, 24, 31, 32, 39, 59, 60,             // B squares
+    18, 21, 42, 45,                             // inner corners
+    19, 20, 26, 29, 34, 37, 43, 44,
+    10, 13, 17, 22, 41, 46, 50, 53,
+    11, 12, 25, 30, 33, 38, 51, 52,
+     1,  6,  8, 15, 48, 55, 57, 62,             // C squares
+     9, 14, 49, 54,                             // X squares
+    27, 28, 35, 36,                             // centre, never empty
+};
+
+// the parity word keeps one bit per quadrant, set while it holds an odd number of empties
+static inline int quadrantBit(int square)
+{
+    return 1 << (((square & 7) >> 2) | (((square >> 3) >> 2) << 1));
+}
+
+int OthelloEndgame::finalDifference(uint64_t own, uint64_t opponent)
+{
+    int difference = popCount(own) - popCount(opponent);
+    int empties = 64 - popCount(own | opponent);
+    if (difference > 0) return difference + empties;
+    if (difference < 0) return difference - empties;
+    return 0;
+}
+
+OthelloEndgame::OthelloEndgame(size_t ttMegabytes)
+    : _tt(ttMegabytes), _stop(false), _nodes(0), _hardTimeMs(0)
+{
+    buildEmptyList(0ULL);
+}
+
+void OthelloEndgame::buildEmptyList(uint64_t empty)
+{
+    int last = Head;
+    for (int square : PresortedSquares) {
+        if (!((empty >> square) & 1)) continue;
+        _next[last] = square;
+        _prev[square] = last;
+        last = square;
+    }
+    _next[last] = Head;
+    _prev[Head] = last;
+}
+
+void OthelloEndgame::checkTime()
+{
+    if (!_hardTimeMs) return;
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _start);
+    if (elapsed.count() >= _hardTimeMs) stop();
+}
+
+// ===========================================================
+// Root
+// ===========================================================
+
+void OthelloEndgame::prepare()
+{
+    _stop.store(false, std::memory_order_relaxed);
+    _start = std::chrono::steady_clock::now();
+}
+
+bool OthelloEndgame::solve(uint64_t own, uint64_t opponent, int64_t hardTimeMs, int &score, int &best)
+{
+    _nodes = 0;
+    _hardTimeMs = hardTimeMs;
+    score = 0;
+    best = -1;
+
+    uint64_t empty = ~(own | opponent);
+    int empties = popCount(empty);
+    buildEmptyList(empty);
+    int parity = 0;
+    for (uint64_t squares = empty; squares; ) parity ^= quadrantBit(popLsb(squares));
+
+    uint64_t moves = OthelloBoard::legalMoves(own, opponent);
+    if (!moves) {
+        if (!OthelloBoard::legalMoves(opponent, own)) {
+            score = finalDifference(own, opponent);
+            return true;
+        }
+        score = -solveDeep(opponent, own, ScoreBelow, ScoreAbove, empties, parity);
+        return !_stop.load(std::memory_order_relaxed);
+    }
+
+    const OthelloTT::Entry *entry = _tt.probe(own, opponent);
+    int ordered[64];
+    int count = orderMoves(own, opponent, moves, entry ? entry->move : -1, ordered);
+    best = ordered[0];
+
+    int alpha = ScoreBelow;
+    for (int i = 0; i < count; i++) {
+        int square = ordered[i];
+        uint64_t flipped = OthelloBoard::flips(square, own, opponent);
+        uint64_t nextOwn = opponent ^ flipped;
+        uint64_t nextOpponent = own | flipped | (1ULL << square);
+
+        removeEmpty(square);
+        int value;
+        if (i == 0) {
+            value = -solveDeep(nextOwn, nextOpponent, -ScoreAbove, -alpha, empties - 1, parity ^ quadrantBit(square));
+        } else {
+            value = -solveDeep(nextOwn, nextOpponent, -alpha - 1, -alpha, empties - 1, parity ^ quadrantBit(square));
+            if (value > alpha)
+                value = -solveDeep(nextOwn, nextOpponent, -ScoreAbove, -alpha, empties - 1, parity ^ quadrantBit(square));
+        }
+        restoreEmpty(square);
+
+        if (_stop.load(std::memory_order_relaxed)) return false;
+        if (value > alpha) {
+            alpha = value;
+            best = square;
+        }
+    }
+
+    _tt.store(own, opponent, alpha, empties, OthelloBoundExact, best);
+    score = alpha;
+    return true;
+}
+
+// ===========================================================
+// Far from the end: table, fastest first, null windows
+// ===========================================================
+
+int OthelloEndgame::orderMoves(uint64_t own, uint64_t opponent, uint64_t moves, int ttMove, int *ordered) const
+{
+    int keys[64];
+    int count = 0;
+    // walking the empty list keeps the presorted order among equal keys
+    for (int square = _next[Head]; square != Head; square = _next[square]) {
+        if (!((moves >> square) & 1)) continue;
+
+        int key;
+        if (square == ttMove) {
+            key = 1 << 20;
+        } else {
+            // the opponent's replies afterwards, corners counting twice
+            uint64_t flipped = OthelloBoard::flips(square, own, opponent);
+            uint64_t replies = OthelloBoard::legalMoves(opponent ^ flipped, own | flipped | (1ULL << square));
+            key = -(popCount(replies) + popCount(replies & Corners));
+        }
+
+        int i = count++;
+        while (i > 0 && keys[i - 1] < key) {
+            keys[i] = keys[i - 1];
+            ordered[i] = ordered[i - 1];
+            i--;
+        }
+        keys[i] = key;
+        ordered[i] = square;
+    }
+    return count;
+}
+
+int OthelloEndgame::solveDeep(uint64_t own, uint64_t opponent, int alpha, int beta, int empties, int parity)
+{
+    if (empties <= ShallowEmpties) return solveShallow(own, opponent, alpha, beta, empties, parity);
+
+    if ((++_nodes & 1023) == 0) checkTime();
+    if (_stop.load(std::memory_order_relaxed)) return 0;
+
+    uint64_t moves = OthelloBoard::legalMoves(own, opponent);
+    if (!moves) {
+        if (!OthelloBoard::legalMoves(opponent, own)) return finalDifference(own, opponent);
+        return -solveDeep(opponent, own, -beta, -alpha, empties, parity);
+    }
+
+    int ttMove = -1;
+    if (const OthelloTT::Entry *entry = _tt.probe(own, opponent)) {
+        // the discs fix the empties, so every entry is solved to the end of the game
+        ttMove = entry->move;
+        int score = entry->score;
+        if (entry->bound == OthelloBoundExact ||
+            (entry->bound == OthelloBoundLower && score >= beta) ||
+            (entry->bound == OthelloBoundUpper && score <= alpha)) {
+            return score;
+        }
+    }
+
+    int ordered[64];
+    int count = orderMoves(own, opponent, moves, ttMove, ordered);
+
+    int oldAlpha = alpha;
+    int best = ScoreBelow;
+    int bestMove = -1;
+    for (int i = 0; i < count; i++) {
+        int square = ordered[i];
+        uint64_t flipped = OthelloBoard::flips(square, own, opponent);
+        uint64_t nextOwn = opponent ^ flipped;
+        uint64_t nextOpponent = own | flipped | (1ULL << square);
+        int nextParity = parity ^ quadrantBit(square);
+
+        removeEmpty(square);
+        int score;
+        if (i == 0) {
+            score = -solveDeep(nextOwn, nextOpponent, -beta, -alpha, empties - 1, nextParity);
+        } else {
+            score = -solveDeep(nextOwn, nextOpponent, -alpha - 1, -alpha, empties - 1, nextParity);
+            if (score > alpha && score < beta)
+                score = -solveDeep(nextOwn, nextOpponent, -beta, -alpha, empties - 1, nextParity);
+        }
+        restoreEmpty(square);
+
+        if (_stop.load(std::memory_order_relaxed)) return 0;
+
+        if (score > best) {
+            best = score;
+            bestMove = square;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) break;
+            }
+        }
+    }
+
+    int bound = best >= beta ? OthelloBoundLower : (best > oldAlpha ? OthelloBoundExact : OthelloBoundUpper);
+    _tt.store(own, opponent, best, empties, bound, bestMove);
+    return best;
+}
+
+// ===========================================================
+// Near the end: the empty list, odd quadrants first
+// ===========================================================
+
+int OthelloEndgame::solveShallow(uint64_t own, uint64_t opponent, int alpha, int beta, int empties, int parity)
+{
+    if (empties == 4) return solve4(own, opponent, alpha, beta, parity);
+    if (empties < 4) {
+        int x[3] = { -1, -1, -1 };
+        int n = 0;
+        for (int square = _next[Head]; square != Head; square = _next[square]) x[n++] = square;
+        if (empties == 3) return solve3(own, opponent, alpha, beta, x[0], x[1], x[2]);
+        if (empties == 2) return solve2(own, opponent, alpha, beta, x[0], x[1]);
+        if (empties == 1) return solve1(own, opponent, x[0]);
+        return finalDifference(own, opponent);
+    }
+
+    _nodes++;
+    int best = ScoreBelow;
+    // the last move in a region is worth having, so odd regions are tried first
+    for (int oddPass = 1; oddPass >= 0; oddPass--) {
+        if (oddPass && !parity) continue;
+        for (int square = _next[Head]; square != Head; square = _next[square]) {
+            if (((parity & quadrantBit(square)) != 0) != (oddPass != 0)) continue;
+            uint64_t flipped = OthelloBoard::flips(square, own, opponent);
+            if (!flipped) continue;
+
+            removeEmpty(square);
+            int score = -solveShallow(opponent ^ flipped, own | flipped | (1ULL << square), -beta, -alpha,
+                                      empties - 1, parity ^ quadrantBit(square));
+            restoreEmpty(square);
+
+            if (score > best) {
+                best = score;
+                if (score >= beta) return best;
+                if (score > alpha) alpha = score;
+            }
+        }
+    }
+    if (best > ScoreBelow) return best;
+
+    if (!OthelloBoard::legalMoves(opponent, own)) return finalDifference(own, opponent);
+    return -solveShallow(opponent, own, -beta, -alpha, empties, parity);
+}
+
+int OthelloEndgame::solve4(uint64_t own, uint64_t opponent, int alpha, int beta, int parity)
+{
+    _nodes++;
+
+    // the four empties, odd quadrants ahead of even ones
+    int x[4];
+    int n = 0;
+    for (int square = _next[Head]; square != Head; square = _next[square])
+        if (parity & quadrantBit(square)) x[n++] = square;
+    for (int square = _next[Head]; square != Head; square = _next[square])
+        if (!(parity & quadrantBit(square))) x[n++] = square;
+
+    static const int Rest[4][3] = { { 1, 2, 3 }, { 0, 2, 3 }, { 0, 1, 3 }, { 0, 1, 2 } };
+    int best = ScoreBelow;
+    for (int i = 0; i < 4; i++) {
+        uint64_t flipped = OthelloBoard::flips(x[i], own, opponent);
+        if (!flipped) continue;
+        int score = -solve3(opponent ^ flipped, own | flipped | (1ULL << x[i]), -beta, -alpha,
+                            x[Rest[i][0]], x[Rest[i][1]], x[Rest[i][2]]);
+        if (score > best) {
+            best = score;
+            if (score >= beta) return best;
+            if (score > alpha) alpha = score;
+        }
+    }
+    if (best > ScoreBelow) return best;
+
+    if (!OthelloBoard::legalMoves(opponent, own)) return finalDifference(own, opponent);
+    return -solve4(opponent, own, -beta, -alpha, parity);
+}
+
+int OthelloEndgame::solve3(uint64_t own, uint64_t opponent, int alpha, int beta, int x1, int x2, int x3)
+{
+    _nodes++;
+
+    // two of the three sharing a quadrant leaves the third alone in its own: that one first
+    if (quadrantBit(x1) == quadrantBit(x2)) {
+        int t = x1; x1 = x3; x3 = x2; x2 = t;
+    } else if (quadrantBit(x1) == quadrantBit(x3)) {
+        int t = x1; x1 = x2; x2 = t;
+    }
+
+    int best = ScoreBelow;
+    uint64_t flipped;
+    if ((flipped = OthelloBoard::flips(x1, own, opponent))) {
+        best = -solve2(opponent ^ flipped, own | flipped | (1ULL << x1), -beta, -alpha, x2, x3);
+        if (best >= beta) return best;
+        if (best > alpha) alpha = best;
+    }
+    if ((flipped = OthelloBoard::flips(x2, own, opponent))) {
+        int score = -solve2(opponent ^ flipped, own | flipped | (1ULL << x2), -beta, -alpha, x1, x3);
+        if (score > best) {
+            best = score;
+            if (best >= beta) return best;
+            if (best > alpha) alpha = best;
+        }
+    }
+    if ((flipped = OthelloBoard::flips(x3, own, opponent))) {
+        int score = -solve2(opponent ^ flipped, own | flipped | (1ULL << x3), -beta, -alpha, x1, x2);
+        if (score > best) best = score;
+    }
+    if (best > ScoreBelow) return best;
+
+    if (!OthelloBoard::legalMoves(opponent, own)) return finalDifference(own, opponent);
+    return -solve3(opponent, own, -beta, -alpha, x1, x2, x3);
+}
+
+int OthelloEndgame::solve2(uint64_t own, uint64_t opponent, int alpha, int beta, int x1, int x2)
+{
+    _nodes++;
+
+    int best = ScoreBelow;
+    uint64_t flipped;
+    if ((flipped = OthelloBoard::flips(x1, own, opponent))) {
+        best = -solve1(opponent ^ flipped, own | flipped | (1ULL << x1), x2);
+        if (best >= beta) return best;
+    }
+    if ((flipped = OthelloBoard::flips(x2, own, opponent))) {
+        int score = -solve1(opponent ^ flipped, own | flipped | (1ULL << x2), x1);
+        if (score > best) best = score;
+    }
+    if (best > ScoreBelow) return best;
+
+    // a pass: the opponent picks the square that is worst for us
+    best = ScoreAbove;
+    if ((flipped = OthelloBoard::flips(x1, opponent, own))) {
+        best = solve1(own ^ flipped, opponent | flipped | (1ULL << x1), x2);
+        if (best <= alpha) return best;
+    }
+    if ((flipped = OthelloBoard::flips(x2, opponent, own))) {
+        int score = solve1(own ^ flipped, opponent | flipped | (1ULL << x2), x1);
+        if (score < best) best = score;
+    }
+    if (best < ScoreAbove) return best;
+
+    return finalDifference(own, opponent);
+}
+
+int OthelloEndgame::solve1(uint64_t own, uint64_t opponent, int x)
+{
+    _nodes++;
+
+    // 63 discs on the board, so the difference is odd and never a draw
+    int difference = 2 * popCount(own) - 63;
+    if (uint64_t flipped = OthelloBoard::flips(x, own, opponent))
+        return difference + 2 * popCount(flipped) + 1;
+    if (uint64_t flipped = OthelloBoard::flips(x, opponent, own))
+        return difference - 2 * popCount(flipped) - 1;
+    return difference > 0 ? difference + 1 : difference - 1;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "OthelloBoard.h"
+#include "OthelloTT.h"
+
+const int OTHELLO_ENDGAME_EMPTIES = 20;    // default switch-over from the midgame search
+
+//
+// exact Othello endgame solver. scores are final disc differences for the side to move,
+// with the empty squares going to the winner, so they run from -64 to 64.
+//
+// the empty squares sit in a linked list presorted corners first and X squares last. far
+// from the end moves are tried fastest first (fewest replies left) behind a transposition
+// table; from 7 empties down the list is walked directly, odd-parity quadrants first, and
+// the last 4, 3, 2 and 1 empties each have their own unrolled routine
+//
+class OthelloEndgame
+{
+public:
+    explicit OthelloEndgame(size_t ttMegabytes = 16);
+
+    // clears the last solve's stop and starts the clock, on the thread that may call stop()
+    void prepare();
+    // solves the position, prepare() must have been called first. best is the move that gets
+    // the score, -1 for a pass. returns false when stopped or past hardTimeMs (0 = no limit,
+    // counted from prepare()) first; best then holds the best root move found so far and score
+    // means nothing
+    bool solve(uint64_t own, uint64_t opponent, int64_t hardTimeMs, int &score, int &best);
+
+    // safe to call from another thread
+    void stop() { _stop.store(true, std::memory_order_relaxed); }
+    void clearTable() { _tt.clear(); }
+    uint64_t nodes() const { return _nodes; }
+
+    // final disc difference of a finished game, empties to the winner
+    static int finalDifference(uint64_t own, uint64_t opponent);
+
+private:
+    int  solveDeep(uint64_t own, uint64_t opponent, int alpha, int beta, int empties, int parity);
+    int  solveShallow(uint64_t own, uint64_t opponent, int alpha, int beta, int empties, int parity);
+    int  solve4(uint64_t own, uint64_t opponent, int alpha, int beta, int parity);
+    int  solve3(uint64_t own, uint64_t opponent, int alpha, int beta, int x1, int x2, int x3);
+    int  solve2(uint64_t own, uint64_t opponent, int alpha, int beta, int x1, int x2);
+    int  solve1(uint64_t own, uint64_t opponent, int x);
+    // fastest first, the table move ahead of everything; returns the count
+    int  orderMoves(uint64_t own, uint64_t opponent, uint64_t moves, int ttMove, int *ordered) const;
+    void checkTime();
+
+    // the empty squares as a doubly linked list through square numbers, Head being the sentinel
+    static const int Head = 64;
+    void buildEmptyList(uint64_t empty);
+    void removeEmpty(int square) { _next[_prev[square]] = _next[square]; _prev[_next[square]] = _prev[square]; }
+    void restoreEmpty(int square) { _next[_prev[square]] = square; _prev[_next[square]] = square; }
+
+    OthelloTT         _tt;
+    std::atomic<bool> _stop;
+    uint64_t          _nodes;
+    int64_t           _hardTimeMs;
+    std::chrono::steady_clock::time_point _start;
+
+    int _next[65];
+    int _prev[65];
+};
@@ -0,0 +1,148 @@
+#include "OthelloEvaluate.h"
+#include "OthelloBoard.h"
+
+static const uint64_t FileA    = 0x0101010101010101ULL;
+static const uint64_t FileH    = 0x8080808080808080ULL;
+static const uint64_t Rank1    = 0x00000000000000FFULL;
+static const uint64_t Rank8    = 0xFF00000000000000ULL;
+static const uint64_t Edges    = FileA | FileH | Rank1 | Rank8;
+static const uint64_t Corners  = 0x8100000000000081ULL;
+
+// weights, in hundredths of a disc
+static const int MobilityWeight  = 9;
+static const int FrontierWeight  = 4;
+static const int CornerWeight    = 80;
+static const int XSquareWeight   = 40;     // diagonally next to an empty corner
+static const int CSquareWeight   = 12;     // on the edge next to an empty corner
+static const int StableWeight    = 16;
+static const int DiscWeightLate  = 6;      // per disc of difference once fewer than 20 squares are empty
+
+// ===========================================================
+// Line masks
+// ===========================================================
+
+struct LineMasks
+{
+    uint64_t rows[8];
+    uint64_t columns[8];
+    uint64_t diagonals[15];         // a1-h8 direction, by x - y + 7
+    uint64_t antiDiagonals[15];     // h1-a8 direction, by x + y
+};
+
+static constexpr LineMasks makeLineMasks()
+{
+    LineMasks masks = {};
+    for (int square = 0; square < 64; square++) {
+        int x = square & 7, y = square >> 3;
+        masks.rows[y] |= 1ULL << square;
+        masks.columns[x] |= 1ULL << square;
+        masks.diagonals[x - y + 7] |= 1ULL << square;
+        masks.antiDiagonals[x + y] |= 1ULL << square;
+    }
+    return masks;
+}
+
+static constexpr LineMasks Lines = makeLineMasks();
+
+// every square on a line with no empty square left
+template <int Count>
+static inline uint64_t fullLines(const uint64_t (&lines)[Count], uint64_t occupied)
+{
+    uint64_t full = 0ULL;
+    for (uint64_t line : lines) {
+        if ((occupied & line) == line) full |= line;
+    }
+    return full;
+}
+
+// ===========================================================
+// Stability
+// ===========================================================
+
+uint64_t stableDiscs(uint64_t own, uint64_t opponent)
+{
+    uint64_t occupied = own | opponent;
+    uint64_t horizontal = fullLines(Lines.rows, occupied) | FileA | FileH;
+    uint64_t vertical = fullLines(Lines.columns, occupied) | Rank1 | Rank8;
+    uint64_t diagonal = fullLines(Lines.diagonals, occupied) | Edges;
+    uint64_t antiDiagonal = fullLines(Lines.antiDiagonals, occupied) | Edges;
+
+    // grow from the corners: along each axis a disc needs a full line, the edge, or a
+    // stable disc of ours beside it on one side, so a turning run can never close over it
+    uint64_t stable = own & Corners;
+    uint64_t previous = 0ULL;
+    while (stable != previous) {
+        previous = stable;
+        uint64_t h = horizontal | ((stable << 1) & ~FileA) | ((stable >> 1) & ~FileH);
+        uint64_t v = vertical | (stable << 8) | (stable >> 8);
+        uint64_t d = diagonal | ((stable << 9) & ~FileA) | ((stable >> 9) & ~FileH);
+        uint64_t a = antiDiagonal | ((stable << 7) & ~FileH) | ((stable >> 7) & ~FileA);
+        stable |= own & h & v & d & a;
+    }
+    return stable;
+}
+
+// ===========================================================
+// Evaluation
+// ===========================================================
+
+// own discs next to an empty square, the ones that hand the opponent moves later
+static inline uint64_t frontier(uint64_t discs, uint64_t empty)
+{
+    uint64_t around = (empty << 8) | (empty >> 8) |
+                      ((empty << 1) & ~FileA) | ((empty >> 1) & ~FileH) |
+                      ((empty << 9) & ~FileA) | ((empty >> 9) & ~FileH) |
+                      ((empty << 7) & ~FileH) | ((empty >> 7) & ~FileA);
+    return discs & around;
+}
+
+// X and C squares of each corner while that corner is empty
+static int cornerNeighbours(uint64_t discs, uint64_t empty)
+{
+    static const int corner[4]  = { 0, 7, 56, 63 };
+    static const int xSquare[4] = { 9, 14, 49, 54 };
+    static const uint64_t cSquares[4] = {
+        (1ULL << 1) | (1ULL << 8), (1ULL << 6) | (1ULL << 15),
+        (1ULL << 48) | (1ULL << 57), (1ULL << 55) | (1ULL << 62),
+    };
+
+    int score = 0;
+    for (int i = 0; i < 4; i++) {
+        if (!((empty >> corner[i]) & 1)) continue;
+        if ((discs >> xSquare[i]) & 1) score -= XSquareWeight;
+        score -= CSquareWeight * popCount(discs & cSquares[i]);
+    }
+    return score;
+}
+
+int evaluateOthello(uint64_t own, uint64_t opponent)
+{
+    uint64_t empty = ~(own | opponent);
+    int score = 0;
+
+    score += MobilityWeight * (popCount(OthelloBoard::legalMoves(own, opponent)) -
+                               popCount(OthelloBoard::legalMoves(opponent, own)));
+    score -= FrontierWeight * (popCount(frontier(own, empty)) - popCount(frontier(opponent, empty)));
+    score += CornerWeight * (popCount(own & Corners) - popCount(opponent & Corners));
+    score += cornerNeighbours(own, empty) - cornerNeighbours(opponent, empty);
+
+    // stability needs a corner to start from
+    if ((own | opponent) & Corners)
+        score += StableWeight * (popCount(stableDiscs(own, opponent)) - popCount(stableDiscs(opponent, own)));
+
+    if (popCount(empty) < 20) score += DiscWeightLate * (popCount(own) - popCount(opponent));
+
+    // a finished game always outranks an evaluation
+    if (score >= OTHELLO_SCORE_WIN) return OTHELLO_SCORE_WIN - 1;
+    if (score <= -OTHELLO_SCORE_WIN) return -OTHELLO_SCORE_WIN + 1;
+    return score;
+}
+
+int finalOthelloScore(uint64_t own, uint64_t opponent)
+{
+    int difference = popCount(own) - popCount(opponent);
+    int empties = 64 - popCount(own | opponent);
+    if (difference > 0) return OTHELLO_SCORE_WIN + difference + empties;
+    if (difference < 0) return -OTHELLO_SCORE_WIN + difference - empties;
+    return 0;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+// a finished game scores beyond any evaluation, plus the final disc difference
+const int OTHELLO_SCORE_WIN = 10000;
+
+//
+// hand-written Othello evaluation, in hundredths of a disc from the mover's side:
+// mobility and potential mobility (frontier discs), corners, the X and C squares next to
+// corners that are still empty, and discs that can never be turned. the disc count only
+// starts to matter as the board fills up.
+//
+int evaluateOthello(uint64_t own, uint64_t opponent);
+
+// score of a finished game for the mover: OTHELLO_SCORE_WIN plus the margin, or 0 for a draw.
+// empty squares go to the winner, as in tournament scoring
+int finalOthelloScore(uint64_t own, uint64_t opponent);
+
+// own discs that no sequence of moves can turn: anchored to a corner or edge, or on a full
+// line, along all four axes. a conservative subset of the truly stable discs
+uint64_t stableDiscs(uint64_t own, uint64_t opponent);
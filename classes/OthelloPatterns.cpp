@@ -0,0 +1,334 @@
+#include "OthelloPatterns.h"
+#include "OthelloBoard.h"
+#include "OthelloEvaluate.h"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+//
+// weight file, little-endian, no padding
+//
+//   char[4]  "GFOP"
+//   uint32   version (1)
+//   uint32   stages, patterns, weights per stage (must match the set compiled in)
+//   int16    weights[stages][weights per stage]
+//
+// each stage holds the eleven pattern tables back to back in the order of PatternShapes,
+// 3^squares weights each. the tables read from the side to move: digit 0 empty, 1 the
+// mover's disc, 2 the opponent's, the pattern's first square the lowest digit.
+//
+
+static const char     PatternMagic[4] = { 'G', 'F', 'O', 'P' };
+static const uint32_t PatternVersion  = 1;
+
+// ===========================================================
+// Pattern set
+// ===========================================================
+
+struct PatternShape
+{
+    int size;
+    int squares[10];
+};
+
+// one copy of each pattern, at the a1 corner or the top edge
+static constexpr PatternShape PatternShapes[OTHELLO_PATTERNS] = {
+    { 10, { 0, 1, 2, 3, 4, 5, 6, 7, 9, 14 } },      // edge with both X squares
+    { 9,  { 0, 1, 2, 8, 9, 10, 16, 17, 18 } },      // 3x3 corner
+    { 10, { 0, 1, 2, 3, 4, 8, 9, 10, 11, 12 } },    // 2x5 corner
+    { 8,  { 8, 9, 10, 11, 12, 13, 14, 15 } },       // row 2
+    { 8,  { 16, 17, 18, 19, 20, 21, 22, 23 } },     // row 3
+    { 8,  { 24, 25, 26, 27, 28, 29, 30, 31 } },     // row 4
+    { 8,  { 0, 9, 18, 27, 36, 45, 54, 63 } },       // main diagonal
+    { 7,  { 1, 10, 19, 28, 37, 46, 55 } },
+    { 6,  { 2, 11, 20, 29, 38, 47 } },
+    { 5,  { 3, 12, 21, 30, 39 } },
+    { 4,  { 4, 13, 22, 31 } },
+};
+
+static const int MaxTouches = 16;
+
+struct FeatureTables
+{
+    int      pattern[OTHELLO_FEATURES];
+    int      size[OTHELLO_FEATURES];
+    int      squares[OTHELLO_FEATURES][10];
+    int      offset[OTHELLO_FEATURES];          // where its pattern's table starts in a stage
+    int      patternOffset[OTHELLO_PATTERNS];
+    int      stageWeights;
+    // the features each square belongs to, and the power of 3 of its digit in each
+    int      touchCount[64];
+    uint8_t  touchFeature[64][MaxTouches];
+    uint16_t touchPower[64][MaxTouches];
+};
+
+// square under one of the eight symmetries of the board
+static constexpr int transformSquare(int square, int symmetry)
+{
+    int x = square & 7, y = square >> 3;
+    if (symmetry & 1) x = 7 - x;
+    if (symmetry & 2) y = 7 - y;
+    if (symmetry & 4) std::swap(x, y);
+    return y * 8 + x;
+}
+
+static constexpr FeatureTables buildFeatures()
+{
+    FeatureTables tables = {};
+    int count = 0;
+    int offset = 0;
+    for (int p = 0; p < OTHELLO_PATTERNS; p++) {
+        const PatternShape &shape = PatternShapes[p];
+        tables.patternOffset[p] = offset;
+
+        uint64_t seen[8] = {};
+        int seenCount = 0;
+        for (int symmetry = 0; symmetry < 8; symmetry++) {
+            uint64_t mask = 0;
+            for (int i = 0; i < shape.size; i++) mask |= 1ULL << transformSquare(shape.squares[i], symmetry);
+            // symmetric patterns map onto themselves, each set of squares is one feature
+            bool duplicate = false;
+            for (int j = 0; j < seenCount; j++) duplicate = duplicate || seen[j] == mask;
+            if (duplicate) continue;
+            seen[seenCount++] = mask;
+
+            tables.pattern[count] = p;
+            tables.size[count] = shape.size;
+            tables.offset[count] = offset;
+            int power = 1;
+            for (int i = 0; i < shape.size; i++) {
+                int square = transformSquare(shape.squares[i], symmetry);
+                tables.squares[count][i] = square;
+                int &touches = tables.touchCount[square];
+                tables.touchFeature[square][touches] = (uint8_t)count;
+                tables.touchPower[square][touches] = (uint16_t)power;
+                touches++;
+                power *= 3;
+            }
+            count++;
+        }
+
+        int entries = 1;
+        for (int i = 0; i < shape.size; i++) entries *= 3;
+        offset += entries;
+    }
+    tables.stageWeights = offset;
+    return tables;
+}
+
+static constexpr FeatureTables Features = buildFeatures();
+
+static constexpr bool touchesFit()
+{
+    for (int square = 0; square < 64; square++) {
+        if (Features.touchCount[square] > MaxTouches) return false;
+    }
+    return true;
+}
+
+static_assert(touchesFit(), "a square belongs to more features than MaxTouches");
+static_assert(Features.offset[OTHELLO_FEATURES - 1] > 0 && Features.pattern[OTHELLO_FEATURES - 1] == OTHELLO_PATTERNS - 1,
+              "the pattern set does not make OTHELLO_FEATURES features");
+
+// the same index with every 1 and 2 swapped: the position as the other side sees it
+static int swapColours(int index)
+{
+    int swapped = 0;
+    for (int power = 1; index; index /= 3, power *= 3) {
+        int digit = index % 3;
+        if (digit) swapped += (3 - digit) * power;
+    }
+    return swapped;
+}
+
+// ===========================================================
+// Features
+// ===========================================================
+
+void OthelloPatterns::compute(uint64_t black, uint64_t white, OthelloFeatures &features)
+{
+    for (int f = 0; f < OTHELLO_FEATURES; f++) {
+        int index = 0;
+        for (int i = Features.size[f] - 1; i >= 0; i--) {
+            int square = Features.squares[f][i];
+            index = index * 3 + (int)((black >> square) & 1) + 2 * (int)((white >> square) & 1);
+        }
+        features.index[f] = (uint16_t)index;
+    }
+}
+
+void OthelloPatterns::update(OthelloFeatures &features, int player, int square, uint64_t flipped)
+{
+    // the new disc turns a 0 digit into 1 or 2, a turned disc moves between 1 and 2
+    int placed = player == OthelloBoard::BlackPlayer ? 1 : 2;
+    int turned = player == OthelloBoard::BlackPlayer ? -1 : 1;
+
+    for (int t = 0; t < Features.touchCount[square]; t++) {
+        uint16_t &index = features.index[Features.touchFeature[square][t]];
+        index = (uint16_t)(index + placed * Features.touchPower[square][t]);
+    }
+    while (flipped) {
+        int turnedSquare = popLsb(flipped);
+        for (int t = 0; t < Features.touchCount[turnedSquare]; t++) {
+            uint16_t &index = features.index[Features.touchFeature[turnedSquare][t]];
+            index = (uint16_t)(index + turned * Features.touchPower[turnedSquare][t]);
+        }
+    }
+}
+
+void OthelloPatterns::slots(const OthelloFeatures &features, int sideToMove, uint32_t *slot)
+{
+    for (int f = 0; f < OTHELLO_FEATURES; f++) {
+        int index = features.index[f];
+        if (sideToMove != OthelloBoard::BlackPlayer) index = swapColours(index);
+        slot[f] = (uint32_t)(Features.offset[f] + index);
+    }
+}
+
+int OthelloPatterns::stageOf(int discs)
+{
+    int stage = (discs - 4) / 10;
+    return stage < 0 ? 0 : (stage >= OTHELLO_PATTERN_STAGES ? OTHELLO_PATTERN_STAGES - 1 : stage);
+}
+
+int OthelloPatterns::stageWeights()
+{
+    return Features.stageWeights;
+}
+
+// ===========================================================
+// Evaluation
+// ===========================================================
+
+int OthelloPatterns::evaluate(const OthelloFeatures &features, int sideToMove, int discs) const
+{
+    const int16_t *table = &_lookup[((size_t)stageOf(discs) * 2 + sideToMove) * Features.stageWeights];
+    int score = 0;
+    for (int f = 0; f < OTHELLO_FEATURES; f++) score += table[Features.offset[f] + features.index[f]];
+
+    // a finished game always outranks an evaluation
+    if (score >= OTHELLO_SCORE_WIN) return OTHELLO_SCORE_WIN - 1;
+    if (score <= -OTHELLO_SCORE_WIN) return -OTHELLO_SCORE_WIN + 1;
+    return score;
+}
+
+void OthelloPatterns::buildLookup()
+{
+    // black to move reads the weights as they are, white to move through swapped colours
+    size_t stageSize = Features.stageWeights;
+    for (int stage = 0; stage < OTHELLO_PATTERN_STAGES; stage++) {
+        const int16_t *weights = &_weights[stage * stageSize];
+        int16_t *black = &_lookup[(stage * 2 + OthelloBoard::BlackPlayer) * stageSize];
+        int16_t *white = &_lookup[(stage * 2 + OthelloBoard::WhitePlayer) * stageSize];
+        std::memcpy(black, weights, stageSize * sizeof(int16_t));
+        for (int p = 0; p < OTHELLO_PATTERNS; p++) {
+            int offset = Features.patternOffset[p];
+            int entries = (p + 1 < OTHELLO_PATTERNS ? Features.patternOffset[p + 1] : Features.stageWeights) - offset;
+            for (int index = 0; index < entries; index++) white[offset + index] = weights[offset + swapColours(index)];
+        }
+    }
+}
+
+// ===========================================================
+// Construction / file io
+// ===========================================================
+
+OthelloPatterns::OthelloPatterns()
+    : _loaded(false),
+      _weights((size_t)OTHELLO_PATTERN_STAGES * Features.stageWeights),
+      _lookup((size_t)OTHELLO_PATTERN_STAGES * 2 * Features.stageWeights)
+{
+}
+
+// reads count values from the file buffer, false if it runs short
+template <typename T>
+static bool readValues(const std::vector<char> &buffer, size_t &offset, T *out, size_t count)
+{
+    size_t bytes = count * sizeof(T);
+    if (offset + bytes > buffer.size()) return false;
+    std::memcpy(out, buffer.data() + offset, bytes);
+    offset += bytes;
+    return true;
+}
+
+template <typename T>
+static void writeValues(std::ofstream &out, const T *values, size_t count)
+{
+    out.write((const char *)values, (std::streamsize)(count * sizeof(T)));
+}
+
+bool OthelloPatterns::load(const std::string &path, std::string &error)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::vector<char> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    size_t offset = 0;
+    char magic[4];
+    uint32_t header[4];
+    if (!readValues(buffer, offset, magic, 4) || std::memcmp(magic, PatternMagic, 4) != 0) {
+        error = path + " is not a pattern weight file";
+        return false;
+    }
+    if (!readValues(buffer, offset, header, 4) || header[0] != PatternVersion) {
+        error = path + " has an unsupported version";
+        return false;
+    }
+    if (header[1] != OTHELLO_PATTERN_STAGES || header[2] != OTHELLO_PATTERNS || header[3] != (uint32_t)Features.stageWeights) {
+        error = path + " has a different pattern set";
+        return false;
+    }
+
+    // read into a copy so a bad file leaves the current weights alone
+    OthelloPatterns patterns;
+    if (!readValues(buffer, offset, patterns._weights.data(), patterns._weights.size()) || offset != buffer.size()) {
+        error = path + " has the wrong size";
+        return false;
+    }
+
+    patterns.buildLookup();
+    patterns._loaded = true;
+    *this = std::move(patterns);
+    return true;
+}
+
+bool OthelloPatterns::save(const std::string &path) const
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+
+    uint32_t header[4] = { PatternVersion, OTHELLO_PATTERN_STAGES, OTHELLO_PATTERNS, (uint32_t)Features.stageWeights };
+    writeValues(out, PatternMagic, 4);
+    writeValues(out, header, 4);
+    writeValues(out, _weights.data(), _weights.size());
+    return (bool)out;
+}
+
+void OthelloPatterns::setWeights(const std::vector<int16_t> &weights)
+{
+    if (weights.size() != _weights.size()) return;
+    _weights = weights;
+    buildLookup();
+    _loaded = true;
+}
+
+void OthelloPatterns::randomize(uint64_t seed)
+{
+    uint64_t state = seed;
+    // splitmix64, values in [-range, range]
+    auto next = [&state](int range) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        return (int)(z % (uint64_t)(2 * range + 1)) - range;
+    };
+
+    for (int16_t &w : _weights) w = (int16_t)next(40);
+    buildLookup();
+    _loaded = true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//
+// pattern evaluation for Othello, an alternative to evaluateOthello()
+//
+// the board is read through 46 features: every rotation and reflection of eleven square
+// patterns (the edge with both X squares, 3x3 and 2x5 corner blocks, rows 2 to 4 and the
+// diagonals of length 4 to 8). a feature's squares read as a base-3 number, 0 empty,
+// 1 black, 2 white, and index a table of weights shared by all copies of its pattern. one
+// set of tables per game stage, and the sum is the score in hundredths of a disc.
+//
+// a move changes a handful of digits, so the search carries the indices down the tree and
+// adds or subtracts powers of 3 instead of reading the board again.
+//
+const int OTHELLO_PATTERNS        = 11;
+const int OTHELLO_FEATURES        = 46;
+const int OTHELLO_PATTERN_STAGES  = 6;     // by disc count, ten moves each
+
+// feature indices, always from black's side, the search keeps one set per ply
+struct OthelloFeatures
+{
+    uint16_t index[OTHELLO_FEATURES];
+};
+
+class OthelloPatterns
+{
+public:
+    OthelloPatterns();
+
+    // reads a weight file (layout in OthelloPatterns.cpp). on failure the weights are
+    // left as they were and error says why
+    bool load(const std::string &path, std::string &error);
+    bool save(const std::string &path) const;
+    // small deterministic random weights, only good for exercising and timing the code
+    void randomize(uint64_t seed);
+    bool loaded() const { return _loaded; }
+
+    // the indices from scratch
+    static void compute(uint64_t black, uint64_t white, OthelloFeatures &features);
+    // after player (OthelloBoard::BlackPlayer or WhitePlayer) put a disc on square and turned flipped
+    static void update(OthelloFeatures &features, int player, int square, uint64_t flipped);
+    // hundredths of a disc from the side to move's point of view
+    int evaluate(const OthelloFeatures &features, int sideToMove, int discs) const;
+
+    // for the fitting tool: the table slot each feature reads, seen from the side to move, so
+    // that the same weight serves black and white. slots run over stageWeights()
+    static void slots(const OthelloFeatures &features, int sideToMove, uint32_t *slot);
+    static int  stageOf(int discs);
+    static int  stageWeights();
+    // all the weights in file order, [stage][slot], from the side to move's point of view
+    const std::vector<int16_t> &weights() const { return _weights; }
+    void setWeights(const std::vector<int16_t> &weights);
+
+private:
+    // rebuilds the tables evaluate() reads from _weights
+    void buildLookup();
+
+    bool                 _loaded;
+    std::vector<int16_t> _weights;     // [stage][slot], side to move's point of view
+    std::vector<int16_t> _lookup;      // [stage][side to move][slot], indexed by the black-side digits
+};
@@ -0,0 +1,275 @@
+#include "OthelloSearch.h"
+#include <iostream>
+#include <sstream>
+
+// move ordering prior: corners first, then the edges, the squares that give a corner away last
+static const int SquareOrder[64] = {
+    90, -20, 20, 10, 10, 20, -20, 90,
+   -20, -50, -5, -5, -5, -5, -50, -20,
+    20,  -5,  5,  2,  2,  5,  -5,  20,
+    10,  -5,  2,  0,  0,  2,  -5,  10,
+    10,  -5,  2,  0,  0,  2,  -5,  10,
+    20,  -5,  5,  2,  2,  5,  -5,  20,
+   -20, -50, -5, -5, -5, -5, -50, -20,
+    90, -20, 20, 10, 10, 20, -20, 90,
+};
+
+std::string othelloSquareName(int square)
+{
+    if (square < 0) return "pass";
+    std::string name;
+    name += (char)('a' + (square & 7));
+    name += (char)('1' + (square >> 3));
+    return name;
+}
+
+std::string formatOthelloReport(const OthelloSearchReport &report)
+{
+    std::ostringstream out;
+    if (report.solved)
+        out << "solved " << report.depth << " empties score ";
+    else
+        out << "depth " << report.depth << " score ";
+    if (report.score >= OTHELLO_SCORE_WIN)
+        out << "win +" << report.score - OTHELLO_SCORE_WIN;
+    else if (report.score <= -OTHELLO_SCORE_WIN)
+        out << "loss " << report.score + OTHELLO_SCORE_WIN;
+    else
+        out << report.score;
+    out << " nodes " << report.nodes << " nps " << report.nps << " time " << report.timeMs << " pv";
+    for (int square : report.pv) out << " " << othelloSquareName(square);
+    return out.str();
+}
+
+// ===========================================================
+// Root / iterative deepening
+// ===========================================================
+
+OthelloSearch::OthelloSearch(size_t ttMegabytes)
+    : _tt(ttMegabytes), _stop(false), _nodes(0), _patterns(nullptr), _rootSide(OthelloBoard::BlackPlayer)
+{
+    _reporter = [](const OthelloSearchReport &report) { std::cout << formatOthelloReport(report) << std::endl; };
+}
+
+void OthelloSearch::setPatterns(const OthelloPatterns *patterns)
+{
+    // table scores from the other evaluation would not compare
+    if (patterns != _patterns) _tt.clear();
+    _patterns = patterns;
+}
+
+void OthelloSearch::prepare()
+{
+    _stop.store(false, std::memory_order_relaxed);
+    _start = std::chrono::steady_clock::now();
+    _endgame.prepare();
+}
+
+int OthelloSearch::search(const OthelloBoard &board, const OthelloSearchLimits &limits)
+{
+    _limits = limits;
+    _nodes = 0;
+    _report = OthelloSearchReport();
+
+    uint64_t own = board.discs(board.sideToMove());
+    uint64_t opponent = board.discs(board.sideToMove() ^ 1);
+    uint64_t moves = OthelloBoard::legalMoves(own, opponent);
+    if (!moves) return -1;
+    // fall back to any legal move in case even depth 1 gets cut short
+    int best = bitScan(moves);
+
+    int empties = popCount(board.empty());
+    if (empties <= limits.endgameEmpties) {
+        int difference;
+        bool solved = _endgame.solve(own, opponent, limits.hardTimeMs, difference, best);
+        // stopped or out of time: the best root move the solver got through is all there is
+        if (!solved) return best;
+
+        _report.depth = empties;
+        _report.score = difference > 0 ? OTHELLO_SCORE_WIN + difference :
+                        difference < 0 ? -OTHELLO_SCORE_WIN + difference : 0;
+        _report.nodes = _endgame.nodes();
+        _report.timeMs = elapsedMs();
+        _report.nps = _report.timeMs > 0 ? _report.nodes * 1000 / _report.timeMs : _report.nodes;
+        _report.pv.assign(1, best);
+        _report.solved = true;
+        if (_reporter) _reporter(_report);
+        return best;
+    }
+
+    _rootSide = board.sideToMove();
+    if (_patterns)
+        OthelloPatterns::compute(board.discs(OthelloBoard::BlackPlayer), board.discs(OthelloBoard::WhitePlayer), _features[0]);
+
+    // every move fills a square, there is nothing to see past the last one
+    int maxDepth = limits.maxDepth < empties ? limits.maxDepth : empties;
+
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        int score = negamax(own, opponent, depth, 0, -OTHELLO_SCORE_INFINITE, OTHELLO_SCORE_INFINITE, true);
+
+        // an aborted iteration is only trusted at depth 1, where anything beats the fallback
+        if (_stop.load(std::memory_order_relaxed) && (depth > 1 || _pvLength[0] == 0)) break;
+
+        best = _pv[0][0];
+
+        _report.depth = depth;
+        _report.score = score;
+        _report.nodes = _nodes;
+        _report.timeMs = elapsedMs();
+        _report.nps = _report.timeMs > 0 ? _nodes * 1000 / _report.timeMs : _nodes;
+        _report.pv.assign(&_pv[0][0], &_pv[0][0] + _pvLength[0]);
+        if (_reporter) _reporter(_report);
+
+        if (_stop.load(std::memory_order_relaxed)) break;
+        if (depth >= limits.minDepth && limits.softTimeMs && _report.timeMs >= limits.softTimeMs) break;
+        if (limits.maxNodes && _nodes >= limits.maxNodes) break;
+    }
+    return best;
+}
+
+int64_t OthelloSearch::elapsedMs() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _start).count();
+}
+
+bool OthelloSearch::timeUp() const
+{
+    if (_limits.hardTimeMs && elapsedMs() >= _limits.hardTimeMs) return true;
+    if (_limits.maxNodes && _nodes >= _limits.maxNodes) return true;
+    return false;
+}
+
+// ===========================================================
+// Evaluation
+// ===========================================================
+
+int OthelloSearch::evaluate(uint64_t own, uint64_t opponent, int ply) const
+{
+    if (!_patterns) return evaluateOthello(own, opponent);
+    return _patterns->evaluate(_features[ply], _rootSide ^ (ply & 1), popCount(own | opponent));
+}
+
+void OthelloSearch::makeFeatures(int ply, int square, uint64_t flipped)
+{
+    if (!_patterns) return;
+    _features[ply + 1] = _features[ply];
+    if (square >= 0) OthelloPatterns::update(_features[ply + 1], _rootSide ^ (ply & 1), square, flipped);
+}
+
+// ===========================================================
+// Move ordering
+// ===========================================================
+
+int OthelloSearch::orderMoves(uint64_t own, uint64_t opponent, uint64_t moves, int ttMove, int depth,
+                              int *ordered) const
+{
+    int keys[64];
+    int count = 0;
+    while (moves) {
+        int square = popLsb(moves);
+        int key = SquareOrder[square];
+        if (square == ttMove) {
+            key = 1 << 20;
+        } else if (depth >= 3) {
+            // fastest first: the fewer replies a move leaves, the sooner it is tried
+            uint64_t flipped = OthelloBoard::flips(square, own, opponent);
+            uint64_t after = OthelloBoard::legalMoves(opponent ^ flipped, own | flipped | (1ULL << square));
+            key -= 16 * popCount(after);
+        }
+
+        // insertion sort, there are rarely more than a dozen moves
+        int i = count++;
+        while (i > 0 && keys[i - 1] < key) {
+            keys[i] = keys[i - 1];
+            ordered[i] = ordered[i - 1];
+            i--;
+        }
+        keys[i] = key;
+        ordered[i] = square;
+    }
+    return count;
+}
+
+// ===========================================================
+// Principal variation search
+// ===========================================================
+
+int OthelloSearch::negamax(uint64_t own, uint64_t opponent, int depth, int ply, int alpha, int beta, bool pvNode)
+{
+    _pvLength[ply] = ply;
+
+    if ((++_nodes & 1023) == 0 && timeUp()) _stop.store(true, std::memory_order_relaxed);
+    if (_stop.load(std::memory_order_relaxed)) return 0;
+
+    uint64_t moves = OthelloBoard::legalMoves(own, opponent);
+    if (!moves) {
+        // neither side can move: the discs decide
+        if (!OthelloBoard::legalMoves(opponent, own)) return finalOthelloScore(own, opponent);
+    }
+    if (depth <= 0 || ply >= OTHELLO_MAX_PLY) return evaluate(own, opponent, ply);
+
+    if (!moves) {
+        // a pass: the opponent moves again, without using up depth
+        makeFeatures(ply, -1, 0ULL);
+        int score = -negamax(opponent, own, depth, ply + 1, -beta, -alpha, pvNode);
+        _pv[ply][ply] = -1;
+        for (int j = ply + 1; j < _pvLength[ply + 1]; j++) _pv[ply][j] = _pv[ply + 1][j];
+        _pvLength[ply] = _pvLength[ply + 1] > ply + 1 ? _pvLength[ply + 1] : ply + 1;
+        return score;
+    }
+
+    int ttMove = -1;
+    if (const OthelloTT::Entry *entry = _tt.probe(own, opponent)) {
+        ttMove = entry->move;
+        if (!pvNode && entry->depth >= depth) {
+            int score = entry->score;
+            if (entry->bound == OthelloBoundExact ||
+                (entry->bound == OthelloBoundLower && score >= beta) ||
+                (entry->bound == OthelloBoundUpper && score <= alpha)) {
+                return score;
+            }
+        }
+    }
+
+    int ordered[64];
+    int count = orderMoves(own, opponent, moves, ttMove, depth, ordered);
+
+    int oldAlpha = alpha;
+    int best = -OTHELLO_SCORE_INFINITE;
+    int bestMove = -1;
+    for (int i = 0; i < count; i++) {
+        int square = ordered[i];
+        uint64_t flipped = OthelloBoard::flips(square, own, opponent);
+        uint64_t nextOwn = opponent ^ flipped;
+        uint64_t nextOpponent = own | flipped | (1ULL << square);
+        makeFeatures(ply, square, flipped);
+
+        int score;
+        if (i == 0) {
+            score = -negamax(nextOwn, nextOpponent, depth - 1, ply + 1, -beta, -alpha, pvNode);
+        } else {
+            // null window first, re-search only if it might raise alpha
+            score = -negamax(nextOwn, nextOpponent, depth - 1, ply + 1, -alpha - 1, -alpha, false);
+            if (pvNode && score > alpha && score < beta)
+                score = -negamax(nextOwn, nextOpponent, depth - 1, ply + 1, -beta, -alpha, true);
+        }
+
+        if (_stop.load(std::memory_order_relaxed)) return 0;
+
+        if (score > best) {
+            best = score;
+            bestMove = square;
+            if (score > alpha) {
+                alpha = score;
+                _pv[ply][ply] = square;
+                for (int j = ply + 1; j < _pvLength[ply + 1]; j++) _pv[ply][j] = _pv[ply + 1][j];
+                _pvLength[ply] = _pvLength[ply + 1] > ply + 1 ? _pvLength[ply + 1] : ply + 1;
+                if (alpha >= beta) break;
+            }
+        }
+    }
+
+    int bound = best >= beta ? OthelloBoundLower : (best > oldAlpha ? OthelloBoundExact : OthelloBoundUpper);
+    _tt.store(own, opponent, best, depth, bound, bestMove);
+    return best;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "OthelloBoard.h"
+#include "OthelloEndgame.h"
+#include "OthelloEvaluate.h"
+#include "OthelloPatterns.h"
+#include "OthelloTT.h"
+
+const int OTHELLO_MAX_PLY       = 128;     // a pass takes a ply without using up depth
+const int OTHELLO_SCORE_INFINITE = 32000;
+
+struct OthelloSearchLimits
+{
+    int      maxDepth   = 60;
+    int      minDepth   = 1;    // always completed unless the hard limit or stop() cuts in
+    int64_t  softTimeMs = 0;    // no new iteration is started past this, 0 = none
+    int64_t  hardTimeMs = 0;    // the search is aborted past this, 0 = none
+    uint64_t maxNodes   = 0;    // 0 = none
+    int      endgameEmpties = OTHELLO_ENDGAME_EMPTIES;  // solved exactly from here down, 0 = never
+};
+
+// one line of progress, produced after every completed iteration
+struct OthelloSearchReport
+{
+    int              depth  = 0;
+    int              score  = 0;
+    uint64_t         nodes  = 0;
+    int64_t          timeMs = 0;
+    uint64_t         nps    = 0;
+    std::vector<int> pv;        // squares, -1 for a pass
+    bool             solved = false;    // exact endgame result: depth is the empties, score the final margin
+};
+
+// "d3", or "pass" for -1
+std::string othelloSquareName(int square);
+// "depth 8 score 35 nodes ... nps ... time ... pv d3 c5 ...", "solved 18 empties score win +6 ..."
+std::string formatOthelloReport(const OthelloSearchReport &report);
+
+//
+// negamax alpha-beta search for Othello with iterative deepening, principal variation
+// search and a transposition table. moves are tried table move first, then by how few
+// replies they leave the opponent, with corners ahead and X squares last. with few enough
+// empty squares the position is handed to OthelloEndgame and solved exactly instead
+//
+class OthelloSearch
+{
+public:
+    explicit OthelloSearch(size_t ttMegabytes = 16);
+
+    // best square for the side to move, -1 when it has to pass or the game is over.
+    // prepare() must have been called first
+    int search(const OthelloBoard &board, const OthelloSearchLimits &limits);
+
+    // clears the last search's stop and starts the clock for the next search(). call it on the
+    // thread that may stop(), before handing search() to another one, so an early stop is kept
+    void prepare();
+
+    // safe to call from another thread, the search returns its best move so far
+    void stop() { _stop.store(true, std::memory_order_relaxed); _endgame.stop(); }
+    void clearTable() { _tt.clear(); _endgame.clearTable(); }
+    // pattern weights to evaluate with, nullptr for evaluateOthello(). not owned, clears the table
+    void setPatterns(const OthelloPatterns *patterns);
+
+    // called after each completed iteration, the default prints formatOthelloReport() to std::cout
+    void setReporter(std::function<void(const OthelloSearchReport &)> reporter) { _reporter = reporter; }
+    const OthelloSearchReport &lastReport() const { return _report; }
+
+private:
+    int  negamax(uint64_t own, uint64_t opponent, int depth, int ply, int alpha, int beta, bool pvNode);
+    int  evaluate(uint64_t own, uint64_t opponent, int ply) const;
+    // the pattern indices one ply down, after square turned flipped (a pass when square < 0)
+    void makeFeatures(int ply, int square, uint64_t flipped);
+    // moves in the order to try them, returns the count
+    int  orderMoves(uint64_t own, uint64_t opponent, uint64_t moves, int ttMove, int depth, int *ordered) const;
+    bool timeUp() const;
+    int64_t elapsedMs() const;
+
+    OthelloTT           _tt;
+    OthelloEndgame      _endgame;
+    OthelloSearchLimits _limits;
+    std::atomic<bool>   _stop;
+    uint64_t            _nodes;
+    std::chrono::steady_clock::time_point _start;
+
+    int _pv[OTHELLO_MAX_PLY + 1][OTHELLO_MAX_PLY + 1];
+    int _pvLength[OTHELLO_MAX_PLY + 1];
+
+    // the mover alternates every ply, passes included, so the root's side fixes all of them
+    const OthelloPatterns *_patterns;
+    int                    _rootSide;
+    OthelloFeatures        _features[OTHELLO_MAX_PLY + 1];
+
+    OthelloSearchReport _report;
+    std::function<void(const OthelloSearchReport &)> _reporter;
+};
@@ -0,0 +1,41 @@
+#include "OthelloTT.h"
+
+OthelloTT::OthelloTT(size_t megabytes)
+    : _mask(0)
+{
+    size_t bytes = (megabytes ? megabytes : 1) * 1024 * 1024;
+    size_t count = 1;
+    while (count * 2 * sizeof(Entry) <= bytes) count *= 2;
+    _entries.resize(count);
+    _mask = count - 1;
+    clear();
+}
+
+void OthelloTT::clear()
+{
+    for (Entry &entry : _entries) entry = Entry{ 0ULL, 0ULL, 0, 0, 0, -1 };
+}
+
+size_t OthelloTT::indexOf(uint64_t own, uint64_t opponent) const
+{
+    uint64_t hash = own * 0x9E3779B97F4A7C15ULL ^ (opponent + 0x632BE59BD9B4E019ULL) * 0xC2B2AE3D27D4EB4FULL;
+    return (size_t)((hash ^ (hash >> 29)) & _mask);
+}
+
+const OthelloTT::Entry *OthelloTT::probe(uint64_t own, uint64_t opponent) const
+{
+    const Entry &entry = _entries[indexOf(own, opponent)];
+    // the full discs are kept, so there are no key collisions to worry about
+    if (entry.bound && entry.own == own && entry.opponent == opponent) return &entry;
+    return nullptr;
+}
+
+void OthelloTT::store(uint64_t own, uint64_t opponent, int score, int depth, int bound, int move)
+{
+    Entry &entry = _entries[indexOf(own, opponent)];
+    bool same = entry.own == own && entry.opponent == opponent;
+    // a deeper result for the same position is kept unless the new one is exact
+    if (same && entry.bound && bound != OthelloBoundExact && depth < entry.depth) return;
+    if (same && move < 0) move = entry.move;
+    entry = Entry{ own, opponent, (int16_t)score, (int8_t)depth, (uint8_t)bound, (int8_t)move };
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum OthelloBound : uint8_t
+{
+    OthelloBoundNone  = 0,
+    OthelloBoundUpper = 1,      // fail low, score is at most this
+    OthelloBoundLower = 2,      // fail high, score is at least this
+    OthelloBoundExact = 3
+};
+
+//
+// single-entry-per-slot transposition table for the Othello searches. positions are keyed
+// by the mover's and the opponent's discs, which is all negamax needs, and the full discs
+// are kept so there are no key collisions. the scores mean whatever the owning search
+// stores: evaluation units for the midgame, final disc differences for the endgame solver
+//
+class OthelloTT
+{
+public:
+    struct Entry
+    {
+        uint64_t own;
+        uint64_t opponent;
+        int16_t  score;
+        int8_t   depth;
+        uint8_t  bound;         // OthelloBound
+        int8_t   move;          // best square, -1 for none
+    };
+
+    explicit OthelloTT(size_t megabytes = 16);
+
+    void clear();
+    const Entry *probe(uint64_t own, uint64_t opponent) const;
+    // depth preferred, always replaced by the current position
+    void store(uint64_t own, uint64_t opponent, int score, int depth, int bound, int move);
+
+private:
+    size_t indexOf(uint64_t own, uint64_t opponent) const;
+
+    std::vector<Entry> _entries;
+    size_t             _mask;
+};
@@ -6,6 +6,32 @@
 #endif
 #include <iostream>
 
+inline int popCount(uint64_t bb) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return (int)__popcnt64(bb);
+#else
+    return __builtin_popcountll(bb);
+#endif
+}
+
+// index of the lowest set bit, bb must not be zero
+inline int bitScan(uint64_t bb) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward64(&index, bb);
+    return (int)index;
+#else
+    return __builtin_ctzll(bb);
+#endif
+}
+
+// return the lowest set bit index and clear it
+inline int popLsb(uint64_t &bb) {
+    int index = bitScan(bb);
+    bb &= bb - 1;
+    return index;
+}
+
 class BitboardElement {
 public:
     // Constructors
@@ -71,21 +97,36 @@ private:
 
 // NOTE: This struct is now independent of ChessPiece.
 // `piece` is just a small integer ID (0 = none, 1 = pawn, etc).
+// `flags` holds the promotion piece ID in the low bits plus the special move bits below.
 struct BitMove {
+    enum Flags : uint8_t {
+        PromotionMask = 0x07,
+        Capture       = 0x08,
+        EnPassant     = 0x10,
+        Castle        = 0x20,
+        DoublePush    = 0x40
+    };
+
     uint8_t from;
     uint8_t to;
     uint8_t piece;
+    uint8_t flags;
 
-    BitMove(int from, int to, uint8_t piece)
+    BitMove(int from, int to, uint8_t piece, uint8_t flags = 0)
         : from(static_cast<uint8_t>(from)),
           to(static_cast<uint8_t>(to)),
-          piece(piece) { }
+          piece(piece),
+          flags(flags) { }
+
+    BitMove() : from(0), to(0), piece(0), flags(0) { }
 
-    BitMove() : from(0), to(0), piece(0) { }
+    uint8_t promotion() const { return flags & PromotionMask; }
+    bool isCapture() const { return (flags & Capture) != 0; }
 
     bool operator==(const BitMove& other) const {
         return from == other.from &&
                to == other.to &&
-               piece == other.piece;
+               piece == other.piece &&
+               flags == other.flags;
     }
 };
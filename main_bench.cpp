@@ -0,0 +1,551 @@
+// Headless benchmarks for the chess engine.
+//
+//   bench smp [depth] [threads...]   Lazy SMP time-to-depth for 1/2/4/8 threads (or the list given)
+//   bench eval [rounds]              static evaluations per second over positions played out from the set,
+//                                    with and without the pawn hash
+//   bench nnue [file] [rounds] [depth]
+//                                    network against hand-written evaluation: accumulator checks,
+//                                    evals/s, updates/s and search nodes/s
+//   bench nnue-kernels [file]        every SIMD kernel the CPU runs must match the scalar one exactly
+//   bench nnue-random <file> [seed]  write a random network, for testing the file loading
+//   bench book [book.bin]            Polyglot key test vectors; with a book, lookups/s and its moves from the start
+//
+// Like perft, only the chess rules and search code is linked.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "classes/ChessAttacks.h"
+#include "classes/ChessBook.h"
+#include "classes/ChessEvaluate.h"
+#include "classes/ChessNNUE.h"
+#include "classes/ChessPosition.h"
+#include "classes/ChessSearch.h"
+#include "classes/ChessTT.h"
+
+// a fixed set so runs on different machines and commits stay comparable
+static const char *kBenchPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+};
+
+static const size_t kBenchHashMB = 64;
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ===========================================================
+// smp: time to reach a fixed depth with each thread count
+// ===========================================================
+
+static int runSmp(int depth, const std::vector<int> &threadCounts)
+{
+    TranspositionTable tt(kBenchHashMB);
+    ChessSearch search(tt);
+    search.setReporter(nullptr);
+
+    SearchLimits limits;
+    limits.maxDepth = depth;
+    limits.minDepth = depth;
+
+    printf("time to depth %d, %zu positions, %zu MB hash\n\n", depth,
+           sizeof(kBenchPositions) / sizeof(kBenchPositions[0]), kBenchHashMB);
+    printf("threads    time (s)   speedup      nodes    Mnodes/s   pawn hits\n");
+
+    double baseline = 0.0;
+    for (int threads : threadCounts) {
+        search.setThreads(threads);
+
+        double seconds = 0.0;
+        uint64_t nodes = 0, pawnHits = 0, pawnProbes = 0;
+        for (const char *fen : kBenchPositions) {
+            ChessPosition position;
+            position.setFEN(fen);
+            // every position starts from an empty table so thread counts compare fairly
+            tt.clear();
+
+            auto start = std::chrono::steady_clock::now();
+            search.prepare();
+            search.search(position, limits);
+            seconds += secondsSince(start);
+            nodes += search.lastReport().nodes;
+
+            uint64_t hits, probes;
+            search.pawnTableStats(hits, probes);
+            pawnHits += hits;
+            pawnProbes += probes;
+        }
+
+        if (baseline == 0.0) baseline = seconds;
+        printf("%7d  %10.3f  %8.2fx  %10llu  %9.2f  %9.1f%%\n", threads, seconds,
+               seconds > 0.0 ? baseline / seconds : 0.0, (unsigned long long)nodes,
+               seconds > 0.0 ? nodes / seconds / 1e6 : 0.0,
+               pawnProbes ? 100.0 * pawnHits / pawnProbes : 0.0);
+    }
+    return 0;
+}
+
+// ===========================================================
+// eval: static evaluation throughput
+// ===========================================================
+
+// the incrementally kept piece-square sums and pawn key must match a count from scratch
+static bool checkIncremental(const ChessPosition &position)
+{
+    int mg, eg, phase;
+    position.computePieceSquare(mg, eg, phase);
+    if (mg != position.pieceSquareMg() || eg != position.pieceSquareEg() || phase != position.phase()) {
+        printf("piece-square mismatch in %s: incremental %d/%d/%d, recomputed %d/%d/%d\n", position.toFEN().c_str(),
+               position.pieceSquareMg(), position.pieceSquareEg(), position.phase(), mg, eg, phase);
+        return false;
+    }
+    if (position.pawnKey() != position.computePawnKey()) {
+        printf("pawn key mismatch in %s\n", position.toFEN().c_str());
+        return false;
+    }
+    return true;
+}
+
+// evaluations per second over every position, rounds times, with or without a pawn hash
+static double timeEval(const std::vector<ChessPosition> &positions, int rounds, ChessPawnTable *pawns,
+                       int64_t &checksum)
+{
+    // the sum keeps the optimiser from dropping the calls
+    checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (const ChessPosition &position : positions)
+            checksum += pawns ? evaluate(position, *pawns) : evaluate(position);
+    }
+    double seconds = secondsSince(start);
+    return seconds > 0.0 ? (double)positions.size() * rounds / seconds : 0.0;
+}
+
+// a fixed pseudo-random game out of every bench position gives openings, middlegames and endings.
+// every legal move on the way is made and taken back once, so unmake is checked as well
+static std::vector<ChessPosition> playOutPositions(bool &consistent)
+{
+    static const int kPliesPerGame = 60;
+    std::vector<ChessPosition> positions;
+    uint32_t seed = 12345;
+    consistent = true;
+
+    for (const char *fen : kBenchPositions) {
+        ChessPosition position;
+        position.setFEN(fen);
+        for (int ply = 0; ply < kPliesPerGame; ply++) {
+            positions.push_back(position);
+            consistent &= checkIncremental(position);
+
+            BitMove moves[MAX_CHESS_MOVES];
+            int count = position.generateLegalMoves(moves);
+            if (count == 0) break;
+
+            for (int i = 0; i < count; i++) {
+                ChessUndo undo;
+                position.makeMove(moves[i], undo);
+                consistent &= checkIncremental(position);
+                position.unmakeMove(moves[i], undo);
+            }
+            consistent &= checkIncremental(position);
+
+            seed = seed * 1664525u + 1013904223u;
+            ChessUndo undo;
+            position.makeMove(moves[(seed >> 16) % count], undo);
+        }
+    }
+    return positions;
+}
+
+static int runEval(int rounds)
+{
+    bool consistent;
+    std::vector<ChessPosition> positions = playOutPositions(consistent);
+
+    printf("%zu positions, %d rounds, incremental sums and pawn key %s\n\n", positions.size(), rounds,
+           consistent ? "consistent" : "MISMATCH");
+
+    int64_t plainSum, cachedSum;
+    ChessPawnTable pawns;
+    double plain = timeEval(positions, rounds, nullptr, plainSum);
+    double cached = timeEval(positions, rounds, &pawns, cachedSum);
+
+    printf("no pawn hash  %8.2f Mevals/s  %6.1f ns/eval\n", plain / 1e6, plain > 0.0 ? 1e9 / plain : 0.0);
+    printf("pawn hash     %8.2f Mevals/s  %6.1f ns/eval  %.1f%% hits\n", cached / 1e6,
+           cached > 0.0 ? 1e9 / cached : 0.0, pawns.probes() ? 100.0 * pawns.hits() / pawns.probes() : 0.0);
+    if (plainSum != cachedSum) {
+        printf("cached and uncached evaluations differ\n");
+        consistent = false;
+    }
+    return consistent ? 0 : 1;
+}
+
+// ===========================================================
+// nnue: network evaluation against the hand-written one
+// ===========================================================
+
+// nodes per second of a fixed depth search over the bench set, with the network or without
+static double searchSpeed(const ChessNetwork *network, int depth, uint64_t &nodes)
+{
+    TranspositionTable tt(kBenchHashMB);
+    ChessSearch search(tt);
+    search.setReporter(nullptr);
+    search.setNetwork(network);
+
+    SearchLimits limits;
+    limits.maxDepth = limits.minDepth = depth;
+
+    double seconds = 0.0;
+    nodes = 0;
+    for (const char *fen : kBenchPositions) {
+        ChessPosition position;
+        position.setFEN(fen);
+        tt.clear();
+        auto start = std::chrono::steady_clock::now();
+        search.prepare();
+        search.search(position, limits);
+        seconds += secondsSince(start);
+        nodes += search.lastReport().nodes;
+    }
+    return seconds > 0.0 ? nodes / seconds : 0.0;
+}
+
+static int runNnue(const char *path, int rounds, int depth)
+{
+    ChessNetwork network;
+    const char *kernels = ChessNetwork::kernelName(ChessNetwork::kernel());
+    if (path) {
+        std::string error;
+        if (!network.load(path, error)) {
+            printf("%s\n", error.c_str());
+            return 1;
+        }
+        printf("network %s, %s kernels\n", path, kernels);
+    } else {
+        network.randomize(1);
+        printf("random network (speed only, it plays no chess), %s kernels\n", kernels);
+    }
+
+    bool consistent;
+    std::vector<ChessPosition> positions = playOutPositions(consistent);
+
+    // every child accumulator updated from its parent must equal one built from scratch
+    std::vector<NNUEAccumulator> accumulators(positions.size());
+    NNUEAccumulator child, fresh;
+    uint64_t updates = 0;
+    for (size_t p = 0; p < positions.size(); p++) {
+        ChessPosition position = positions[p];
+        network.refresh(position, accumulators[p]);
+
+        BitMove moves[MAX_CHESS_MOVES];
+        int count = position.generateLegalMoves(moves);
+        for (int i = 0; i < count; i++) {
+            ChessUndo undo;
+            position.makeMove(moves[i], undo);
+            child.dirtyCount = undo.dirtyCount;
+            for (int d = 0; d < undo.dirtyCount; d++) child.dirty[d] = undo.dirty[d];
+            network.update(accumulators[p], child);
+            network.refresh(position, fresh);
+            if (std::memcmp(child.values, fresh.values, sizeof(fresh.values)) != 0) {
+                printf("accumulator mismatch after %s in %s\n", moveToString(moves[i]).c_str(),
+                       positions[p].toFEN().c_str());
+                consistent = false;
+            }
+            position.unmakeMove(moves[i], undo);
+            updates++;
+        }
+    }
+    printf("%zu positions, %llu incremental updates %s\n\n", positions.size(), (unsigned long long)updates,
+           consistent ? "match a full refresh" : "MISMATCH");
+
+    int64_t checksum = 0;
+    ChessPawnTable pawns;
+    double handWritten = timeEval(positions, rounds, &pawns, checksum);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (size_t p = 0; p < positions.size(); p++) checksum += network.evaluate(positions[p], accumulators[p]);
+    }
+    double seconds = secondsSince(start);
+    double nnue = seconds > 0.0 ? (double)positions.size() * rounds / seconds : 0.0;
+
+    // a typical quiet move: one piece leaves a square and lands on another
+    child.dirtyCount = 1;
+    child.dirty[0] = DirtyPiece{ WHITE, Knight, 6, 21 };
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (size_t p = 0; p < positions.size(); p++) {
+            network.update(accumulators[p], child);
+            checksum += child.values[WHITE][0];
+        }
+    }
+    seconds = secondsSince(start);
+    double updateRate = seconds > 0.0 ? (double)positions.size() * rounds / seconds : 0.0;
+
+    printf("hand-written eval  %8.2f Mevals/s\n", handWritten / 1e6);
+    printf("network eval       %8.2f Mevals/s\n", nnue / 1e6);
+    printf("accumulator update %8.2f Mupdates/s (checksum %lld)\n\n", updateRate / 1e6, (long long)checksum);
+
+    uint64_t nodes;
+    double handNps = searchSpeed(nullptr, depth, nodes);
+    printf("search depth %d, hand-written  %10llu nodes  %6.2f Mnodes/s\n", depth, (unsigned long long)nodes,
+           handNps / 1e6);
+    double nnueNps = searchSpeed(&network, depth, nodes);
+    printf("search depth %d, network       %10llu nodes  %6.2f Mnodes/s\n", depth, (unsigned long long)nodes,
+           nnueNps / 1e6);
+    return consistent ? 0 : 1;
+}
+
+// ===========================================================
+// nnue-kernels: every kernel the CPU can run against the scalar one
+// ===========================================================
+
+// the accumulator and evaluation of every position and every child, refreshed and updated
+static void runNetwork(const ChessNetwork &network, const std::vector<ChessPosition> &positions,
+                       std::vector<int16_t> &values, std::vector<int> &evals)
+{
+    values.clear();
+    evals.clear();
+    NNUEAccumulator parent, child;
+    for (ChessPosition position : positions) {
+        network.refresh(position, parent);
+        values.insert(values.end(), &parent.values[0][0], &parent.values[0][0] + 2 * NNUE_HIDDEN);
+        evals.push_back(network.evaluate(position, parent));
+
+        BitMove moves[MAX_CHESS_MOVES];
+        int count = position.generateLegalMoves(moves);
+        for (int i = 0; i < count; i++) {
+            ChessUndo undo;
+            position.makeMove(moves[i], undo);
+            child.dirtyCount = undo.dirtyCount;
+            for (int d = 0; d < undo.dirtyCount; d++) child.dirty[d] = undo.dirty[d];
+            network.update(parent, child);
+            values.insert(values.end(), &child.values[0][0], &child.values[0][0] + 2 * NNUE_HIDDEN);
+            evals.push_back(network.evaluate(position, child));
+            position.unmakeMove(moves[i], undo);
+        }
+    }
+}
+
+static int runNnueKernels(const char *path)
+{
+    ChessNetwork network;
+    if (path) {
+        std::string error;
+        if (!network.load(path, error)) {
+            printf("%s\n", error.c_str());
+            return 1;
+        }
+    } else {
+        network.randomize(1);
+    }
+
+    bool consistent;
+    std::vector<ChessPosition> positions = playOutPositions(consistent);
+
+    ChessNetwork::Kernel selected = ChessNetwork::kernel();
+    std::vector<int16_t> expectedValues, values;
+    std::vector<int> expectedEvals, evals;
+    ChessNetwork::setKernel(ChessNetwork::KernelScalar);
+    runNetwork(network, positions, expectedValues, expectedEvals);
+    printf("%zu positions, %zu accumulators and evaluations each\n", positions.size(), expectedEvals.size());
+
+    static const ChessNetwork::Kernel kKernels[] = { ChessNetwork::KernelScalar, ChessNetwork::KernelSSE2,
+                                                     ChessNetwork::KernelAVX2 };
+    bool match = true;
+    for (ChessNetwork::Kernel kernel : kKernels) {
+        const char *name = ChessNetwork::kernelName(kernel);
+        if (!ChessNetwork::setKernel(kernel)) {
+            printf("%-6s  not supported here\n", name);
+            continue;
+        }
+        auto start = std::chrono::steady_clock::now();
+        runNetwork(network, positions, values, evals);
+        double seconds = secondsSince(start);
+        bool same = values == expectedValues && evals == expectedEvals;
+        match &= same;
+        printf("%-6s  %s  %6.2f M updates+evals/s%s\n", name, same ? "matches scalar" : "MISMATCH      ",
+               seconds > 0.0 ? evals.size() / seconds / 1e6 : 0.0, kernel == selected ? "  (selected)" : "");
+    }
+    ChessNetwork::setKernel(selected);
+    return match ? 0 : 1;
+}
+
+// ===========================================================
+// book: Polyglot keys and lookup speed
+// ===========================================================
+
+// the test vectors from the Polyglot book format description
+struct PolyglotVector
+{
+    const char *moves;
+    uint64_t    key;
+};
+
+static const PolyglotVector kPolyglotVectors[] = {
+    { "",                                   0x463b96181691fc9cULL },
+    { "e2e4",                               0x823c9b50fd114196ULL },
+    { "e2e4 d7d5",                          0x0756b94461c50fb0ULL },
+    { "e2e4 d7d5 e4e5",                     0x662fafb965db29d4ULL },
+    { "e2e4 d7d5 e4e5 f7f5",                0x22a48b5a8e47ff78ULL },
+    { "e2e4 d7d5 e4e5 f7f5 e1e2",           0x652a607ca3f242c1ULL },
+    { "e2e4 d7d5 e4e5 f7f5 e1e2 e8f7",      0x00fdd303c946bdd9ULL },
+    { "a2a4 b7b5 h2h4 b5b4 c2c4",           0x3c8123ea7b067637ULL },
+    { "a2a4 b7b5 h2h4 b5b4 c2c4 b4c3 a1a3", 0x5c3f9b829b279560ULL },
+};
+
+// plays UCI moves from the start position, false on an illegal one
+static bool playMoves(ChessPosition &position, const char *moves)
+{
+    position.setFEN(ChessPosition::StartFEN);
+    std::istringstream in(moves);
+    std::string text;
+    while (in >> text) {
+        BitMove list[MAX_CHESS_MOVES];
+        int count = position.generateLegalMoves(list);
+        int i = 0;
+        while (i < count && moveToString(list[i]) != text) i++;
+        if (i == count) return false;
+        ChessUndo undo;
+        position.makeMove(list[i], undo);
+    }
+    return true;
+}
+
+static int runBook(const char *bookPath)
+{
+    // a wrong key shows up here before any lookup goes wrong
+    bool keysMatch = true;
+    for (const PolyglotVector &vector : kPolyglotVectors) {
+        ChessPosition position;
+        playMoves(position, vector.moves);
+        uint64_t key = ChessBook::key(position);
+        if (key != vector.key) {
+            printf("key mismatch after \"%s\": %016llx, expected %016llx\n", vector.moves,
+                   (unsigned long long)key, (unsigned long long)vector.key);
+            keysMatch = false;
+        }
+    }
+    printf("Polyglot key test vectors %s\n", keysMatch ? "match" : "DO NOT match");
+    if (!bookPath) return keysMatch ? 0 : 1;
+
+    ChessBook book;
+    std::string error;
+    if (!book.open(bookPath, error)) {
+        printf("%s\n", error.c_str());
+        return 1;
+    }
+    printf("\n%s: %zu entries, memory mapped\n", bookPath, book.size());
+
+    ChessPosition start;
+    start.setFEN(ChessPosition::StartFEN);
+    std::vector<BookMove> moves;
+    book.movesFor(start, moves);
+    printf("start position:");
+    for (const BookMove &entry : moves) printf(" %s (%u)", moveToString(entry.move).c_str(), entry.weight);
+    printf("%s\n", moves.empty() ? " not in book" : "");
+
+    // played out positions give a mix of hits near the start and misses later on
+    bool consistent;
+    std::vector<ChessPosition> positions = playOutPositions(consistent);
+    static const int kRounds = 20;
+    uint64_t found = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; round++) {
+        for (const ChessPosition &position : positions) found += book.movesFor(position, moves);
+    }
+    double seconds = secondsSince(begin);
+    uint64_t lookups = (uint64_t)positions.size() * kRounds;
+    printf("%llu lookups in %.3f s, %.2f Mlookups/s (%llu moves found)\n", (unsigned long long)lookups, seconds,
+           seconds > 0.0 ? lookups / seconds / 1e6 : 0.0, (unsigned long long)found);
+    return keysMatch ? 0 : 1;
+}
+
+static void usage()
+{
+    printf("usage: bench smp [depth, default 8] [thread counts, default 1 2 4 8]\n");
+    printf("       bench eval [rounds, default 20000]\n");
+    printf("       bench nnue [network file, default random weights] [rounds, default 2000] [depth, default 6]\n");
+    printf("       bench nnue-kernels [network file, default random weights]\n");
+    printf("       bench nnue-random <output file> [seed]\n");
+    printf("       bench book [book.bin]\n");
+}
+
+int main(int argc, char **argv)
+{
+    initChessAttacks();
+    printf("Chess attack tables initialized in %.2f ms\n", chessAttacksInitMs());
+
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+
+    if (std::strcmp(argv[1], "smp") == 0) {
+        int depth = argc > 2 ? std::atoi(argv[2]) : 8;
+        std::vector<int> threadCounts;
+        for (int i = 3; i < argc; i++) threadCounts.push_back(std::atoi(argv[i]));
+        if (threadCounts.empty()) threadCounts = { 1, 2, 4, 8 };
+        if (depth <= 0) {
+            usage();
+            return 1;
+        }
+        return runSmp(depth, threadCounts);
+    }
+
+    if (std::strcmp(argv[1], "eval") == 0) {
+        int rounds = argc > 2 ? std::atoi(argv[2]) : 20000;
+        if (rounds <= 0) {
+            usage();
+            return 1;
+        }
+        return runEval(rounds);
+    }
+
+    if (std::strcmp(argv[1], "nnue") == 0) {
+        const char *path = argc > 2 && std::strcmp(argv[2], "random") != 0 ? argv[2] : nullptr;
+        int rounds = argc > 3 ? std::atoi(argv[3]) : 2000;
+        int depth = argc > 4 ? std::atoi(argv[4]) : 6;
+        if (rounds <= 0 || depth <= 0) {
+            usage();
+            return 1;
+        }
+        return runNnue(path, rounds, depth);
+    }
+
+    if (std::strcmp(argv[1], "nnue-kernels") == 0) {
+        return runNnueKernels(argc > 2 ? argv[2] : nullptr);
+    }
+
+    if (std::strcmp(argv[1], "book") == 0) {
+        return runBook(argc > 2 ? argv[2] : nullptr);
+    }
+
+    // a network file of the right shape for trying out the loader and the engine options
+    if (std::strcmp(argv[1], "nnue-random") == 0 && argc > 2) {
+        ChessNetwork network;
+        network.randomize(argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1);
+        if (!network.save(argv[2])) {
+            printf("cannot write %s\n", argv[2]);
+            return 1;
+        }
+        printf("wrote random network to %s\n", argv[2]);
+        return 0;
+    }
+
+    usage();
+    return 1;
+}
@@ -0,0 +1,546 @@
+// Headless checks and benchmarks for the Othello engine.
+//
+//   othello perft [depth]   leaf counts from the start against the published ones, with the
+//                           bitboard moves and flips checked against a square-by-square scan
+//   othello search [depth] [positions]
+//                           fixed-depth alpha-beta over a set of midgame positions reached by
+//                           seeded random play, with per-position nodes and the overall nodes/s
+//   othello endgame [empties] [positions] [file.obf]
+//                           exact solves of seeded random positions with that many empties, or
+//                           of the positions in an FFO-style .obf file (64 squares of X, O or -,
+//                           then the side to move), checked against the midgame search at full
+//                           depth up to 14 empties
+//   othello kernels [rounds]
+//                           the scalar and AVX2 move generation and flip kernels: checked against
+//                           each other, then timed alone and inside the midgame and endgame searches
+//   othello patterns [weights.bin]
+//                           the pattern evaluation: incremental indices checked against a recount
+//                           along random games, then evaluations/s and search nodes/s against the
+//                           hand-written evaluation. random weights when no file is given
+//
+// Like perft for chess, only the engine code is linked, no ImGui or GLFW.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include "classes/OthelloBoard.h"
+#include "classes/OthelloEndgame.h"
+#include "classes/OthelloPatterns.h"
+#include "classes/OthelloSearch.h"
+
+// leaf counts from the start position, a pass counting as a move
+static const uint64_t kPerftCounts[] = {
+    1ULL, 4ULL, 12ULL, 56ULL, 244ULL, 1396ULL, 8200ULL, 55092ULL, 390216ULL,
+    3005288ULL, 24571284ULL, 212258800ULL, 1939886636ULL,
+};
+static const int kPerftKnownDepth = (int)(sizeof(kPerftCounts) / sizeof(kPerftCounts[0])) - 1;
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ===========================================================
+// Reference: one square and one direction at a time
+// ===========================================================
+
+static uint64_t referenceFlips(int square, uint64_t own, uint64_t opponent)
+{
+    static const int kDirections[8][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 },
+                                           { 1, 1 }, { -1, -1 }, { 1, -1 }, { -1, 1 } };
+    if (((own | opponent) >> square) & 1) return 0ULL;
+
+    uint64_t flipped = 0ULL;
+    for (const auto &direction : kDirections) {
+        uint64_t line = 0ULL;
+        int x = (square & 7) + direction[0];
+        int y = (square >> 3) + direction[1];
+        while (x >= 0 && x < 8 && y >= 0 && y < 8 && ((opponent >> (y * 8 + x)) & 1)) {
+            line |= 1ULL << (y * 8 + x);
+            x += direction[0];
+            y += direction[1];
+        }
+        if (line && x >= 0 && x < 8 && y >= 0 && y < 8 && ((own >> (y * 8 + x)) & 1)) flipped |= line;
+    }
+    return flipped;
+}
+
+// ===========================================================
+// perft
+// ===========================================================
+
+static uint64_t perft(OthelloBoard &board, int depth, bool check, bool &ok)
+{
+    if (depth == 0) return 1;
+
+    uint64_t own = board.discs(board.sideToMove());
+    uint64_t opponent = board.discs(board.sideToMove() ^ 1);
+    uint64_t moves = OthelloBoard::legalMoves(own, opponent);
+
+    if (check) {
+        uint64_t expected = 0ULL;
+        for (int square = 0; square < 64; square++) {
+            uint64_t flipped = OthelloBoard::flips(square, own, opponent);
+            if (flipped != referenceFlips(square, own, opponent)) ok = false;
+            if (flipped) expected |= 1ULL << square;
+        }
+        if (expected != moves) ok = false;
+    }
+
+    if (!moves) {
+        // a finished game is a leaf however deep it was asked to go
+        if (board.gameOver()) return 1;
+        board.pass();
+        uint64_t nodes = perft(board, depth - 1, check, ok);
+        board.pass();
+        return nodes;
+    }
+
+    uint64_t nodes = 0;
+    while (moves) {
+        int square = popLsb(moves);
+        uint64_t flipped = board.play(square);
+        nodes += perft(board, depth - 1, check, ok);
+        board.undo(square, flipped);
+    }
+    return nodes;
+}
+
+static int runPerft(int maxDepth)
+{
+    printf("%5s %14s %14s %10s %8s\n", "depth", "nodes", "expected", "time (s)", "Mnodes/s");
+    bool allOk = true;
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        OthelloBoard board;
+        bool ok = true;
+        // the slow reference scan only on the shallow depths
+        bool check = depth <= 8;
+        auto start = std::chrono::steady_clock::now();
+        uint64_t nodes = perft(board, depth, check, ok);
+        double seconds = secondsSince(start);
+
+        char expected[32] = "?";
+        if (depth <= kPerftKnownDepth) {
+            snprintf(expected, sizeof(expected), "%llu", (unsigned long long)kPerftCounts[depth]);
+            if (nodes != kPerftCounts[depth]) ok = false;
+        }
+        printf("%5d %14llu %14s %10.3f %8.2f%s\n", depth, (unsigned long long)nodes, expected, seconds,
+               seconds > 0 ? nodes / seconds / 1e6 : 0.0, ok ? "" : "  MISMATCH");
+        allOk &= ok;
+    }
+    printf("%s\n", allOk ? "all counts match" : "mismatch");
+    return allOk ? 0 : 1;
+}
+
+// ===========================================================
+// search benchmark
+// ===========================================================
+
+// the same positions on every run: random legal moves from the start with a fixed seed,
+// until plies moves are played or only empties squares are left
+static std::vector<OthelloBoard> benchPositions(int count, int plies, int empties = 0)
+{
+    std::vector<OthelloBoard> positions;
+    std::mt19937 random(20240601);
+    while ((int)positions.size() < count) {
+        OthelloBoard board;
+        for (int ply = 0; ply < plies && popCount(board.empty()) > empties && !board.gameOver(); ply++) {
+            if (board.mustPass()) {
+                board.pass();
+                continue;
+            }
+            uint64_t moves = OthelloBoard::legalMoves(board.discs(board.sideToMove()),
+                                                      board.discs(board.sideToMove() ^ 1));
+            int pick = (int)(random() % popCount(moves));
+            while (pick--) moves &= moves - 1;
+            board.play(bitScan(moves));
+        }
+        if (!board.gameOver() && !board.mustPass()) positions.push_back(board);
+    }
+    return positions;
+}
+
+static int runSearch(int depth, int count)
+{
+    OthelloSearch search;
+    search.setReporter(nullptr);
+    OthelloSearchLimits limits;
+    limits.maxDepth = depth;
+
+    printf("%3s %-66s %5s %6s %12s %9s %10s\n", "#", "position", "move", "score", "nodes", "time (s)", "nodes/s");
+    uint64_t totalNodes = 0;
+    double totalSeconds = 0;
+    std::vector<OthelloBoard> positions = benchPositions(count, 20);
+    for (size_t i = 0; i < positions.size(); i++) {
+        // every position from a cold table, so the counts do not depend on the order
+        search.clearTable();
+        auto start = std::chrono::steady_clock::now();
+        search.prepare();
+        int move = search.search(positions[i], limits);
+        double seconds = secondsSince(start);
+
+        const OthelloSearchReport &report = search.lastReport();
+        std::string position = positions[i].toString() + (positions[i].sideToMove() == OthelloBoard::BlackPlayer ? " b" : " w");
+        printf("%3d %-66s %5s %6d %12llu %9.3f %10.0f\n", (int)i + 1, position.c_str(),
+               othelloSquareName(move).c_str(), report.score, (unsigned long long)report.nodes, seconds,
+               seconds > 0 ? report.nodes / seconds : 0.0);
+        totalNodes += report.nodes;
+        totalSeconds += seconds;
+    }
+    printf("total %llu nodes in %.3f s, %.0f nodes/s\n", (unsigned long long)totalNodes, totalSeconds,
+           totalSeconds > 0 ? totalNodes / totalSeconds : 0.0);
+    return 0;
+}
+
+// ===========================================================
+// endgame benchmark
+// ===========================================================
+
+// one position per line, "X" black, "O" white, "-" empty, then the side to move
+static bool loadObf(const char *path, std::vector<OthelloBoard> &positions)
+{
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.size() < 66) continue;
+        std::string state(64, '0');
+        bool ok = true;
+        for (int square = 0; square < 64 && ok; square++) {
+            switch (line[square]) {
+                case 'X': case 'x': case '*': state[square] = '1'; break;
+                case 'O': case 'o': state[square] = '2'; break;
+                case '-': case '.': break;
+                default: ok = false;
+            }
+        }
+        char side = line[65];
+        if (!ok || (side != 'X' && side != 'x' && side != 'O' && side != 'o')) continue;
+
+        OthelloBoard board;
+        board.setString(state, side == 'X' || side == 'x' ? OthelloBoard::BlackPlayer : OthelloBoard::WhitePlayer);
+        positions.push_back(board);
+    }
+    return true;
+}
+
+static int runEndgame(int empties, int count, const char *path)
+{
+    std::vector<OthelloBoard> positions;
+    if (path) {
+        if (!loadObf(path, positions)) {
+            printf("cannot read %s\n", path);
+            return 1;
+        }
+    } else {
+        positions = benchPositions(count, 60, empties);
+    }
+
+    OthelloEndgame endgame;
+    OthelloSearch search;
+    search.setReporter(nullptr);
+    OthelloSearchLimits fullDepth;
+    fullDepth.endgameEmpties = 0;
+
+    printf("%3s %-66s %7s %5s %6s %12s %9s %10s\n", "#", "position", "empties", "move", "discs", "nodes",
+           "time (s)", "nodes/s");
+    uint64_t totalNodes = 0;
+    double totalSeconds = 0;
+    bool allOk = true;
+    for (size_t i = 0; i < positions.size(); i++) {
+        const OthelloBoard &board = positions[i];
+        uint64_t own = board.discs(board.sideToMove());
+        uint64_t opponent = board.discs(board.sideToMove() ^ 1);
+
+        // every position from a cold table, so the counts do not depend on the order
+        endgame.clearTable();
+        int score = 0, move = -1;
+        auto start = std::chrono::steady_clock::now();
+        endgame.prepare();
+        endgame.solve(own, opponent, 0, score, move);
+        double seconds = secondsSince(start);
+        uint64_t nodes = endgame.nodes();
+
+        // the slower midgame search reaches the same end of the game at full depth
+        bool ok = true;
+        int positionEmpties = popCount(board.empty());
+        if (positionEmpties <= 14) {
+            search.clearTable();
+            search.prepare();
+            search.search(board, fullDepth);
+            int expected = search.lastReport().score;
+            if (expected >= OTHELLO_SCORE_WIN) expected -= OTHELLO_SCORE_WIN;
+            else if (expected <= -OTHELLO_SCORE_WIN) expected += OTHELLO_SCORE_WIN;
+            if (OthelloBoard::legalMoves(own, opponent) && expected != score) ok = false;
+        }
+
+        std::string position = board.toString() + (board.sideToMove() == OthelloBoard::BlackPlayer ? " b" : " w");
+        printf("%3d %-66s %7d %5s %+6d %12llu %9.3f %10.0f%s\n", (int)i + 1, position.c_str(), positionEmpties,
+               othelloSquareName(move).c_str(), score, (unsigned long long)nodes, seconds,
+               seconds > 0 ? nodes / seconds : 0.0, ok ? "" : "  MISMATCH");
+        totalNodes += nodes;
+        totalSeconds += seconds;
+        allOk &= ok;
+    }
+    printf("total %llu nodes in %.3f s, %.0f nodes/s\n", (unsigned long long)totalNodes, totalSeconds,
+           totalSeconds > 0 ? totalNodes / totalSeconds : 0.0);
+    if (!allOk) printf("mismatch\n");
+    return allOk ? 0 : 1;
+}
+
+// ===========================================================
+// kernel microbenchmark
+// ===========================================================
+
+struct KernelTimes
+{
+    double movesPerSecond = 0;
+    double flipsPerSecond = 0;
+    double searchNps = 0;
+    double endgameNps = 0;
+};
+
+static KernelTimes timeKernel(const std::vector<OthelloBoard> &positions, int rounds, uint64_t &checksum)
+{
+    KernelTimes times;
+
+    uint64_t calls = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (const OthelloBoard &board : positions) {
+            checksum += OthelloBoard::legalMoves(board.discs(0), board.discs(1));
+            checksum += OthelloBoard::legalMoves(board.discs(1), board.discs(0));
+            calls += 2;
+        }
+    }
+    double seconds = secondsSince(start);
+    times.movesPerSecond = seconds > 0 ? calls / seconds : 0;
+
+    calls = 0;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (const OthelloBoard &board : positions) {
+            uint64_t own = board.discs(board.sideToMove());
+            uint64_t opponent = board.discs(board.sideToMove() ^ 1);
+            for (uint64_t moves = board.legalMoves(); moves; calls++)
+                checksum += OthelloBoard::flips(popLsb(moves), own, opponent);
+        }
+    }
+    seconds = secondsSince(start);
+    times.flipsPerSecond = seconds > 0 ? calls / seconds : 0;
+
+    OthelloSearch search;
+    search.setReporter(nullptr);
+    OthelloSearchLimits limits;
+    limits.maxDepth = 8;
+    uint64_t nodes = 0;
+    start = std::chrono::steady_clock::now();
+    for (const OthelloBoard &board : benchPositions(4, 20)) {
+        search.clearTable();
+        search.prepare();
+        checksum += search.search(board, limits);
+        nodes += search.lastReport().nodes;
+    }
+    seconds = secondsSince(start);
+    times.searchNps = seconds > 0 ? nodes / seconds : 0;
+
+    OthelloEndgame endgame;
+    nodes = 0;
+    start = std::chrono::steady_clock::now();
+    for (const OthelloBoard &board : benchPositions(4, 60, 16)) {
+        int score = 0, move = -1;
+        endgame.clearTable();
+        endgame.prepare();
+        endgame.solve(board.discs(board.sideToMove()), board.discs(board.sideToMove() ^ 1), 0, score, move);
+        checksum += score;
+        nodes += endgame.nodes();
+    }
+    seconds = secondsSince(start);
+    times.endgameNps = seconds > 0 ? nodes / seconds : 0;
+    return times;
+}
+
+static int runKernels(int rounds)
+{
+    // positions from every stage of the game
+    std::vector<OthelloBoard> positions;
+    for (int plies = 2; plies <= 58; plies += 4) {
+        std::vector<OthelloBoard> stage = benchPositions(32, plies);
+        positions.insert(positions.end(), stage.begin(), stage.end());
+    }
+
+    OthelloBoard::Kernel original = OthelloBoard::kernel();
+    printf("default kernel: %s\n", OthelloBoard::kernelName(original));
+    bool haveAvx2 = OthelloBoard::kernelSupported(OthelloBoard::KernelAVX2);
+    if (!haveAvx2) printf("AVX2 is not available on this CPU, timing the scalar kernel only\n");
+
+    bool ok = true;
+    if (haveAvx2) {
+        // every square of every position, both sides, through both kernels
+        std::vector<uint64_t> expected;
+        OthelloBoard::setKernel(OthelloBoard::KernelScalar);
+        for (const OthelloBoard &board : positions) {
+            for (int side = 0; side < 2; side++) {
+                uint64_t own = board.discs(side), opponent = board.discs(side ^ 1);
+                expected.push_back(OthelloBoard::legalMoves(own, opponent));
+                for (int square = 0; square < 64; square++) expected.push_back(OthelloBoard::flips(square, own, opponent));
+            }
+        }
+        OthelloBoard::setKernel(OthelloBoard::KernelAVX2);
+        size_t next = 0;
+        for (const OthelloBoard &board : positions) {
+            for (int side = 0; side < 2; side++) {
+                uint64_t own = board.discs(side), opponent = board.discs(side ^ 1);
+                if (OthelloBoard::legalMoves(own, opponent) != expected[next++]) ok = false;
+                for (int square = 0; square < 64; square++)
+                    if (OthelloBoard::flips(square, own, opponent) != expected[next++]) ok = false;
+            }
+        }
+        printf("%zu positions, AVX2 %s the scalar kernel\n", positions.size(), ok ? "matches" : "DOES NOT MATCH");
+    }
+
+    printf("%-8s %14s %14s %14s %14s\n", "kernel", "moves/s", "flips/s", "search nps", "endgame nps");
+    uint64_t checksums[2] = { 0, 0 };
+    for (int kernel = OthelloBoard::KernelScalar; kernel <= OthelloBoard::KernelAVX2; kernel++) {
+        if (!OthelloBoard::setKernel((OthelloBoard::Kernel)kernel)) continue;
+        KernelTimes times = timeKernel(positions, rounds, checksums[kernel]);
+        printf("%-8s %14.0f %14.0f %14.0f %14.0f\n", OthelloBoard::kernelName((OthelloBoard::Kernel)kernel),
+               times.movesPerSecond, times.flipsPerSecond, times.searchNps, times.endgameNps);
+    }
+    if (haveAvx2 && checksums[0] != checksums[1]) {
+        printf("the two kernels searched differently\n");
+        ok = false;
+    }
+
+    OthelloBoard::setKernel(original);
+    return ok ? 0 : 1;
+}
+
+// ===========================================================
+// pattern evaluation
+// ===========================================================
+
+static int runPatterns(const char *path)
+{
+    OthelloPatterns patterns;
+    if (path) {
+        std::string error;
+        if (!patterns.load(path, error)) {
+            printf("%s\n", error.c_str());
+            return 1;
+        }
+        printf("weights from %s\n", path);
+    } else {
+        patterns.randomize(1);
+        printf("random weights\n");
+    }
+
+    // indices carried through random games against a recount, and the white-to-move
+    // lookup against the weights read through swapped colours
+    std::mt19937 random(7);
+    bool ok = true;
+    int checked = 0;
+    std::vector<OthelloBoard> positions;
+    for (int game = 0; game < 200; game++) {
+        OthelloBoard board;
+        OthelloFeatures features;
+        OthelloPatterns::compute(board.discs(OthelloBoard::BlackPlayer), board.discs(OthelloBoard::WhitePlayer), features);
+        while (!board.gameOver()) {
+            if (board.mustPass()) {
+                board.pass();
+                continue;
+            }
+            uint64_t moves = board.legalMoves();
+            int pick = (int)(random() % popCount(moves));
+            while (pick--) moves &= moves - 1;
+            int square = bitScan(moves);
+            int player = board.sideToMove();
+            uint64_t flipped = board.play(square);
+            OthelloPatterns::update(features, player, square, flipped);
+
+            OthelloFeatures recount;
+            OthelloPatterns::compute(board.discs(OthelloBoard::BlackPlayer), board.discs(OthelloBoard::WhitePlayer), recount);
+            if (std::memcmp(&features, &recount, sizeof(features)) != 0) ok = false;
+
+            int discs = 64 - popCount(board.empty());
+            uint32_t slots[OTHELLO_FEATURES];
+            OthelloPatterns::slots(features, board.sideToMove(), slots);
+            const int16_t *weights = &patterns.weights()[(size_t)OthelloPatterns::stageOf(discs) * OthelloPatterns::stageWeights()];
+            int expected = 0;
+            for (uint32_t slot : slots) expected += weights[slot];
+            expected = std::clamp(expected, -OTHELLO_SCORE_WIN + 1, OTHELLO_SCORE_WIN - 1);
+            if (patterns.evaluate(features, board.sideToMove(), discs) != expected) ok = false;
+
+            positions.push_back(board);
+            checked++;
+        }
+    }
+    printf("%d positions, incremental indices and lookups %s\n", checked, ok ? "match" : "DO NOT MATCH");
+
+    // evaluations per second, each from the board as a leaf would see it
+    const int rounds = 20;
+    int64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++)
+        for (const OthelloBoard &board : positions)
+            checksum += evaluateOthello(board.discs(board.sideToMove()), board.discs(board.sideToMove() ^ 1));
+    double handSeconds = secondsSince(start);
+
+    std::vector<OthelloFeatures> features(positions.size());
+    for (size_t i = 0; i < positions.size(); i++)
+        OthelloPatterns::compute(positions[i].discs(OthelloBoard::BlackPlayer), positions[i].discs(OthelloBoard::WhitePlayer), features[i]);
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++)
+        for (size_t i = 0; i < positions.size(); i++)
+            checksum += patterns.evaluate(features[i], positions[i].sideToMove(), 64 - popCount(positions[i].empty()));
+    double patternSeconds = secondsSince(start);
+
+    uint64_t evaluations = (uint64_t)rounds * positions.size();
+    printf("%-12s %14s %14s\n", "evaluation", "evals/s", "search nps");
+    for (int usePatterns = 0; usePatterns < 2; usePatterns++) {
+        OthelloSearch search;
+        search.setReporter(nullptr);
+        search.setPatterns(usePatterns ? &patterns : nullptr);
+        OthelloSearchLimits limits;
+        limits.maxDepth = 8;
+        uint64_t nodes = 0;
+        start = std::chrono::steady_clock::now();
+        for (const OthelloBoard &board : benchPositions(10, 20)) {
+            search.clearTable();
+            search.prepare();
+            checksum += search.search(board, limits);
+            nodes += search.lastReport().nodes;
+        }
+        double searchSeconds = secondsSince(start);
+        double evalSeconds = usePatterns ? patternSeconds : handSeconds;
+        printf("%-12s %14.0f %14.0f\n", usePatterns ? "patterns" : "hand-written",
+               evalSeconds > 0 ? evaluations / evalSeconds : 0.0, searchSeconds > 0 ? nodes / searchSeconds : 0.0);
+    }
+    printf("checksum %lld\n", (long long)checksum);
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "perft") return runPerft(argc > 2 ? std::atoi(argv[2]) : 9);
+    if (mode == "search") return runSearch(argc > 2 ? std::atoi(argv[2]) : 8, argc > 3 ? std::atoi(argv[3]) : 10);
+    if (mode == "patterns") return runPatterns(argc > 2 ? argv[2] : nullptr);
+    if (mode == "kernels") return runKernels(argc > 2 ? std::atoi(argv[2]) : 2000);
+    if (mode == "endgame")
+        return runEndgame(argc > 2 ? std::atoi(argv[2]) : 18, argc > 3 ? std::atoi(argv[3]) : 10, argc > 4 ? argv[4] : nullptr);
+
+    printf("usage: othello perft [depth]\n"
+           "       othello search [depth] [positions]\n"
+           "       othello endgame [empties] [positions] [file.obf]\n"
+           "       othello kernels [rounds]\n"
+           "       othello patterns [weights.bin]\n");
+    return 1;
+}
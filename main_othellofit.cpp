@@ -0,0 +1,264 @@
+// Offline fitting of the Othello pattern weights read by OthelloPatterns.
+//
+//   othellofit selfplay <records.txt> <games> [depth] [weights.bin]
+//                           plays games with the alpha-beta search and appends them to the
+//                           records: a few random opening moves, then the search at that depth
+//                           (4 by default) and exact play over the last 14 empties. with a
+//                           weight file the search evaluates with it, for a next round
+//   othellofit fit <records.txt> <weights.bin> [epochs]
+//                           fits every pattern weight to the final disc difference of the games,
+//                           by stochastic gradient descent, and writes the weight file
+//
+// A record is one game per line, the moves as square names with passes left out
+// ("f5d6c3..."), then the final black minus white disc count. Lines starting with '#' are
+// skipped. Every tenth game is held out to measure the fit on positions it has not seen.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include "classes/OthelloBoard.h"
+#include "classes/OthelloEndgame.h"
+#include "classes/OthelloPatterns.h"
+#include "classes/OthelloSearch.h"
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ===========================================================
+// Records
+// ===========================================================
+
+// the moves of one record line, false if a square name is malformed
+static bool parseMoves(const std::string &line, std::vector<int> &moves)
+{
+    moves.clear();
+    size_t i = 0;
+    while (i + 1 < line.size() && line[i] != ' ') {
+        int x = line[i] - 'a', y = line[i + 1] - '1';
+        if (x < 0 || x > 7 || y < 0 || y > 7) return false;
+        moves.push_back(y * 8 + x);
+        i += 2;
+    }
+    return true;
+}
+
+// plays the moves out, passing where the side to move has to. false if one is illegal
+static bool replay(const std::vector<int> &moves, std::vector<OthelloBoard> &positions, OthelloBoard &final)
+{
+    positions.clear();
+    OthelloBoard board;
+    for (int square : moves) {
+        if (board.mustPass()) board.pass();
+        if (!board.isLegal(square)) return false;
+        positions.push_back(board);
+        board.play(square);
+    }
+    final = board;
+    return true;
+}
+
+static int countRecords(const char *path)
+{
+    std::ifstream in(path);
+    std::string line;
+    int count = 0;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line[0] != '#') count++;
+    }
+    return count;
+}
+
+// ===========================================================
+// Self-play
+// ===========================================================
+
+static int runSelfPlay(const char *path, int games, int depth, const char *weightsPath)
+{
+    OthelloPatterns patterns;
+    OthelloSearch search;
+    search.setReporter(nullptr);
+    if (weightsPath) {
+        std::string error;
+        if (!patterns.load(weightsPath, error)) {
+            printf("%s\n", error.c_str());
+            return 1;
+        }
+        search.setPatterns(&patterns);
+    }
+
+    OthelloSearchLimits limits;
+    limits.maxDepth = depth;
+    limits.endgameEmpties = 14;
+
+    // seeded by how many games are already there, so appending never repeats a game
+    int first = countRecords(path);
+    std::ofstream out(path, std::ios::app);
+    if (!out) {
+        printf("cannot write %s\n", path);
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int game = first; game < first + games; game++) {
+        std::mt19937 random((uint32_t)game * 2654435761u + 1);
+        int randomPlies = 6 + (int)(random() % 8);
+
+        OthelloBoard board;
+        std::string record;
+        for (int ply = 0; !board.gameOver(); ply++) {
+            if (board.mustPass()) {
+                board.pass();
+                continue;
+            }
+            int square;
+            if (ply < randomPlies) {
+                uint64_t moves = board.legalMoves();
+                int pick = (int)(random() % popCount(moves));
+                while (pick--) moves &= moves - 1;
+                square = bitScan(moves);
+            } else {
+                search.prepare();
+                square = search.search(board, limits);
+            }
+            record += othelloSquareName(square);
+            board.play(square);
+        }
+
+        int difference = board.count(OthelloBoard::BlackPlayer) - board.count(OthelloBoard::WhitePlayer);
+        out << record << " " << (difference > 0 ? "+" : "") << difference << "\n";
+        if ((game - first + 1) % 10 == 0 || game + 1 == first + games) {
+            printf("%d games, %.1f s\n", game - first + 1, secondsSince(start));
+            fflush(stdout);
+        }
+    }
+    return out ? 0 : 1;
+}
+
+// ===========================================================
+// Fitting
+// ===========================================================
+
+struct Sample
+{
+    uint32_t slots[OTHELLO_FEATURES];
+    int      stage;
+    float    target;     // final disc difference for the side to move, hundredths
+};
+
+static void addSamples(const std::vector<OthelloBoard> &positions, const OthelloBoard &final, std::vector<Sample> &samples)
+{
+    // empties go to the winner, as the search scores finished games
+    int blackResult = OthelloEndgame::finalDifference(final.discs(OthelloBoard::BlackPlayer),
+                                                      final.discs(OthelloBoard::WhitePlayer));
+    for (const OthelloBoard &board : positions) {
+        OthelloFeatures features;
+        OthelloPatterns::compute(board.discs(OthelloBoard::BlackPlayer), board.discs(OthelloBoard::WhitePlayer), features);
+
+        Sample sample;
+        OthelloPatterns::slots(features, board.sideToMove(), sample.slots);
+        sample.stage = OthelloPatterns::stageOf(64 - popCount(board.empty()));
+        sample.target = 100.0f * (board.sideToMove() == OthelloBoard::BlackPlayer ? blackResult : -blackResult);
+        samples.push_back(sample);
+    }
+}
+
+static float predict(const std::vector<float> &weights, const Sample &sample)
+{
+    const float *stage = &weights[(size_t)sample.stage * OthelloPatterns::stageWeights()];
+    float sum = 0;
+    for (uint32_t slot : sample.slots) sum += stage[slot];
+    return sum;
+}
+
+// root mean square error in discs
+static double rmse(const std::vector<float> &weights, const std::vector<Sample> &samples)
+{
+    if (samples.empty()) return 0;
+    double total = 0;
+    for (const Sample &sample : samples) {
+        double error = (sample.target - predict(weights, sample)) / 100.0;
+        total += error * error;
+    }
+    return std::sqrt(total / samples.size());
+}
+
+static int runFit(const char *recordsPath, const char *weightsPath, int epochs)
+{
+    std::ifstream in(recordsPath);
+    if (!in) {
+        printf("cannot read %s\n", recordsPath);
+        return 1;
+    }
+
+    std::vector<Sample> training, validation;
+    std::vector<int> moves;
+    std::vector<OthelloBoard> positions;
+    OthelloBoard final;
+    std::string line;
+    int games = 0, rejected = 0;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        // only finished games carry a result
+        if (!parseMoves(line, moves) || !replay(moves, positions, final) || !final.gameOver()) {
+            rejected++;
+            continue;
+        }
+        addSamples(positions, final, games % 10 == 9 ? validation : training);
+        games++;
+    }
+    printf("%d games, %zu training and %zu held-out positions", games, training.size(), validation.size());
+    if (rejected) printf(", %d records rejected", rejected);
+    printf("\n");
+    if (training.empty()) return 1;
+
+    std::vector<float> weights((size_t)OTHELLO_PATTERN_STAGES * OthelloPatterns::stageWeights(), 0.0f);
+    std::mt19937 random(1);
+    auto start = std::chrono::steady_clock::now();
+    for (int epoch = 0; epoch < epochs; epoch++) {
+        // every sample moves its 46 weights; the rate keeps one step well short of the error
+        float rate = 0.004f / (1.0f + epoch * 0.25f);
+        std::shuffle(training.begin(), training.end(), random);
+        for (const Sample &sample : training) {
+            float step = rate * (sample.target - predict(weights, sample));
+            float *stage = &weights[(size_t)sample.stage * OthelloPatterns::stageWeights()];
+            for (uint32_t slot : sample.slots) stage[slot] += step;
+        }
+        printf("epoch %3d  training rmse %6.2f  held-out rmse %6.2f discs  %.1f s\n", epoch + 1,
+               rmse(weights, training), rmse(weights, validation), secondsSince(start));
+        fflush(stdout);
+    }
+
+    std::vector<int16_t> rounded(weights.size());
+    for (size_t i = 0; i < weights.size(); i++)
+        rounded[i] = (int16_t)std::clamp((long)std::lround(weights[i]), -32767L, 32767L);
+
+    OthelloPatterns patterns;
+    patterns.setWeights(rounded);
+    if (!patterns.save(weightsPath)) {
+        printf("cannot write %s\n", weightsPath);
+        return 1;
+    }
+    printf("wrote %s\n", weightsPath);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "selfplay" && argc >= 4)
+        return runSelfPlay(argv[2], std::atoi(argv[3]), argc > 4 ? std::atoi(argv[4]) : 4, argc > 5 ? argv[5] : nullptr);
+    if (mode == "fit" && argc >= 4) return runFit(argv[2], argv[3], argc > 4 ? std::atoi(argv[4]) : 20);
+
+    printf("usage: othellofit selfplay <records.txt> <games> [depth] [weights.bin]\n"
+           "       othellofit fit <records.txt> <weights.bin> [epochs]\n");
+    return 1;
+}
@@ -0,0 +1,198 @@
+// Headless perft runner for the chess move generator.
+//
+//   perft <depth> [fen]      divide counts per root move, total nodes and speed
+//   perft --suite [depth]    standard positions against their published counts
+//   perft --parity [depth]   legal generator against the pseudo-legal one on the same positions
+//
+// No ImGui, GLFW or textures are linked, only the chess rules code.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "classes/ChessAttacks.h"
+#include "classes/ChessPerft.h"
+#include "classes/ChessPosition.h"
+
+struct PerftSuiteEntry
+{
+    const char *name;
+    const char *fen;
+    uint64_t    counts[6];  // depth 1..6, 0 where not listed
+};
+
+// counts from the chessprogramming.org perft results page
+static const PerftSuiteEntry kPerftSuite[] = {
+    { "startpos",  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+      { 20, 400, 8902, 197281, 4865609, 119060324 } },
+    { "kiwipete",  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+      { 48, 2039, 97862, 4085603, 193690690, 0 } },
+    { "position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+      { 14, 191, 2812, 43238, 674624, 11030083 } },
+    { "position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+      { 6, 264, 9467, 422333, 15833292, 0 } },
+    { "position4m", "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",
+      { 6, 264, 9467, 422333, 15833292, 0 } },
+    { "position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+      { 44, 1486, 62379, 2103487, 89941194, 0 } },
+    { "position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+      { 46, 2079, 89890, 3894594, 164075551, 0 } },
+};
+
+// positions built around en passant discoveries, castling through check and promotions,
+// run by --parity on top of the suite
+static const char *kParityPositions[] = {
+    "3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1",
+    "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1",
+    "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1",
+    "5k2/8/8/8/8/8/8/4K2R w K - 0 1",
+    "3k4/8/8/8/8/8/8/R3K3 w Q - 0 1",
+    "r3k2r/1b4bq/8/8/8/8/7B/R3K2R w KQkq - 0 1",
+    "r3k2r/8/3Q4/8/8/5q2/8/R3K2R b KQkq - 0 1",
+    "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1",
+    "8/8/1P2K3/8/2n5/1q6/8/5k2 b - - 0 1",
+    "8/k1P5/8/1K6/8/8/8/8 w - - 0 1",
+    "8/8/2k5/5q2/5n2/8/5K2/8 b - - 0 1",
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void printSpeed(uint64_t nodes, double seconds)
+{
+    printf("Nodes: %llu\n", (unsigned long long)nodes);
+    printf("Time:  %.3f s\n", seconds);
+    printf("Speed: %.2f Mnodes/s\n", seconds > 0.0 ? nodes / seconds / 1e6 : 0.0);
+}
+
+static int runDivide(int depth, const std::string &fen)
+{
+    ChessPosition position;
+    if (!position.setFEN(fen)) {
+        fprintf(stderr, "bad FEN: %s\n", fen.c_str());
+        return 1;
+    }
+
+    printf("perft %d  %s\n", depth, fen.c_str());
+    auto start = std::chrono::steady_clock::now();
+    uint64_t nodes = perftDivide(position, depth, std::cout);
+    double seconds = secondsSince(start);
+
+    printf("\n");
+    printSpeed(nodes, seconds);
+    return 0;
+}
+
+static int runSuite(int maxDepth)
+{
+    int failures = 0;
+    uint64_t totalNodes = 0;
+    auto suiteStart = std::chrono::steady_clock::now();
+
+    for (const PerftSuiteEntry &entry : kPerftSuite) {
+        ChessPosition position;
+        position.setFEN(entry.fen);
+
+        for (int depth = 1; depth <= maxDepth && depth <= 6 && entry.counts[depth - 1]; depth++) {
+            auto start = std::chrono::steady_clock::now();
+            uint64_t nodes = perft(position, depth);
+            double seconds = secondsSince(start);
+            bool ok = nodes == entry.counts[depth - 1];
+
+            printf("%-11s depth %d  %12llu  %s  %8.2f Mnodes/s\n", entry.name, depth,
+                   (unsigned long long)nodes, ok ? "ok  " : "FAIL",
+                   seconds > 0.0 ? nodes / seconds / 1e6 : 0.0);
+            if (!ok) {
+                printf("            expected %llu\n", (unsigned long long)entry.counts[depth - 1]);
+                failures++;
+            }
+            totalNodes += nodes;
+        }
+    }
+
+    printf("\n");
+    printSpeed(totalNodes, secondsSince(suiteStart));
+    printf("%s\n", failures ? "FAILED" : "all counts match");
+    return failures ? 1 : 0;
+}
+
+// the legal generator and the filtered pseudo-legal one must agree everywhere
+static int runParity(int maxDepth)
+{
+    int failures = 0;
+    double legalSeconds = 0.0, pseudoSeconds = 0.0;
+
+    std::vector<std::pair<std::string, std::string>> positions;
+    for (const PerftSuiteEntry &entry : kPerftSuite) positions.push_back({ entry.name, entry.fen });
+    for (size_t i = 0; i < sizeof(kParityPositions) / sizeof(kParityPositions[0]); i++)
+        positions.push_back({ "edge" + std::to_string(i + 1), kParityPositions[i] });
+
+    for (const auto &entry : positions) {
+        ChessPosition position;
+        position.setFEN(entry.second);
+
+        for (int depth = 1; depth <= maxDepth; depth++) {
+            auto start = std::chrono::steady_clock::now();
+            uint64_t legal = perft(position, depth);
+            legalSeconds += secondsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            uint64_t pseudo = perftPseudoLegal(position, depth);
+            pseudoSeconds += secondsSince(start);
+
+            bool ok = legal == pseudo;
+            printf("%-11s depth %d  legal %12llu  pseudo-legal %12llu  %s\n", entry.first.c_str(), depth,
+                   (unsigned long long)legal, (unsigned long long)pseudo, ok ? "ok" : "FAIL");
+            if (!ok) failures++;
+        }
+    }
+
+    printf("\nlegal %.3f s, pseudo-legal %.3f s\n", legalSeconds, pseudoSeconds);
+    printf("%s\n", failures ? "FAILED" : "generators agree");
+    return failures ? 1 : 0;
+}
+
+static void usage()
+{
+    printf("usage: perft <depth> [fen]\n");
+    printf("       perft --suite [max depth, default 4]\n");
+    printf("       perft --parity [max depth, default 4]\n");
+}
+
+int main(int argc, char **argv)
+{
+    initChessAttacks();
+    printf("Chess attack tables initialized in %.2f ms\n", chessAttacksInitMs());
+
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+
+    if (std::strcmp(argv[1], "--suite") == 0) {
+        return runSuite(argc > 2 ? std::atoi(argv[2]) : 4);
+    }
+    if (std::strcmp(argv[1], "--parity") == 0) {
+        return runParity(argc > 2 ? std::atoi(argv[2]) : 4);
+    }
+
+    int depth = std::atoi(argv[1]);
+    if (depth <= 0) {
+        usage();
+        return 1;
+    }
+
+    std::string fen;
+    for (int i = 2; i < argc; i++) {
+        if (!fen.empty()) fen += ' ';
+        fen += argv[i];
+    }
+    return runDivide(depth, fen.empty() ? ChessPosition::StartFEN : fen);
+}
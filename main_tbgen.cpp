@@ -0,0 +1,391 @@
+// Offline generator for the chess endgame tablebases read by ChessTablebase.
+//
+//   tbgen <directory> <max pieces>         every table from 3 pieces up to the limit
+//   tbgen <directory> <signature> [...]    only these, e.g. KQvK KRvK (their subtables must exist)
+//
+// Tables are built by retrograde analysis: a forward pass scores every position that ends
+// the game or leaves the table (captures and promotions, looked up in the smaller tables
+// already written), then results are spread backwards through un-moves. A second pass
+// measures the distance to the next zeroing move (DTZ) the same way, level by level.
+//
+// Sizes grow by 64x per piece: 3 pieces take well under a second, 4 pieces take minutes
+// and about 32 MB per file, 5 are possible but take 2 GiB per file, as no symmetry is
+// folded out of the index. The engines only probe 5-piece tables when told to.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <vector>
+#include "classes/ChessAttacks.h"
+#include "classes/ChessPosition.h"
+#include "classes/ChessTablebase.h"
+
+// working value while a table is built, never written out
+static const uint8_t kUnknown = 4;
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ===========================================================
+// Un-moves
+// ===========================================================
+
+//
+// every position one move earlier that stays in the table: a piece of the side that just
+// moved steps back to an empty square. pawns step back too unless pawnMoves is false,
+// the DTZ pass leaves them out because a pawn move resets the count.
+//
+static int predecessors(uint64_t index, const TablebaseLayout &layout, bool pawnMoves, uint64_t *out)
+{
+    int squares[TablebaseLayout::MaxPieces];
+    uint64_t rest = index;
+    uint64_t occupied = 0ULL;
+    for (int i = layout.count - 1; i >= 0; i--) {
+        squares[i] = (int)(rest & 63);
+        occupied |= 1ULL << squares[i];
+        rest >>= 6;
+    }
+    int mover = (int)rest ^ 1;
+    uint64_t empty = ~occupied;
+
+    int count = 0;
+    for (int i = 0; i < layout.count; i++) {
+        if (layout.player[i] != mover) continue;
+        int square = squares[i];
+
+        uint64_t from = 0ULL;
+        switch (layout.piece[i]) {
+            case King:   from = kingAttacks(square) & empty; break;
+            case Queen:  from = queenAttacks(square, occupied) & empty; break;
+            case Rook:   from = rookAttacks(square, occupied) & empty; break;
+            case Bishop: from = bishopAttacks(square, occupied) & empty; break;
+            case Knight: from = knightAttacks(square) & empty; break;
+            case Pawn: {
+                if (!pawnMoves) break;
+                int step = mover == WHITE ? -8 : 8;
+                int rank = mover == WHITE ? square >> 3 : 7 - (square >> 3);
+                // a pawn on its second rank has not moved yet
+                if (rank >= 2 && (empty & (1ULL << (square + step)))) {
+                    from |= 1ULL << (square + step);
+                    if (rank == 3 && (empty & (1ULL << (square + 2 * step)))) from |= 1ULL << (square + 2 * step);
+                }
+                break;
+            }
+        }
+
+        while (from) {
+            int previous[TablebaseLayout::MaxPieces];
+            std::copy(squares, squares + layout.count, previous);
+            previous[i] = popLsb(from);
+            out[count++] = ChessTablebase::composeIndex(mover, previous, layout);
+        }
+    }
+    return count;
+}
+
+// ===========================================================
+// Generation
+// ===========================================================
+
+struct GenerationStats
+{
+    uint64_t counts[4][2];  // TBValue by side to move
+    int      longestDtz;
+};
+
+static bool leavesTable(const BitMove &move)
+{
+    return move.isCapture() || move.promotion();
+}
+
+// value of a child position outside this table, from its side to move
+static bool externalValue(const ChessTablebase &tablebase, const ChessPosition &child, TBValue &value)
+{
+    if (tablebase.probeWDL(child, value)) return true;
+    bool flip;
+    printf("  missing subtable %s, generate it first\n", ChessTablebase::signatureOf(child, flip).c_str());
+    return false;
+}
+
+static bool generateTable(const std::string &directory, const std::string &signature, GenerationStats &stats)
+{
+    TablebaseLayout layout;
+    if (!ChessTablebase::layoutFor(signature, layout)) {
+        printf("  not a signature: %s\n", signature.c_str());
+        return false;
+    }
+
+    // subtables are read from the directory as they are needed
+    ChessTablebase tablebase;
+    tablebase.setPath(directory);
+
+    const uint64_t size = layout.size();
+    std::vector<uint8_t> wdl(size, kUnknown);
+    std::vector<uint8_t> remaining(size, 0);    // moves inside the table not yet known to lose
+    std::vector<uint8_t> fallback(size, TBLoss); // best result over the moves that leave the table
+    std::vector<uint64_t> queue;
+    uint64_t previous[256];
+
+    // -------------------------------
+    // forward pass: mates, stalemates and everything decided by a capture or promotion
+    // -------------------------------
+    ChessPosition position;
+    for (uint64_t index = 0; index < size; index++) {
+        if (!ChessTablebase::positionAt(index, layout, position)) {
+            wdl[index] = TBInvalid;
+            continue;
+        }
+
+        BitMove moves[MAX_CHESS_MOVES];
+        int count = position.generateLegalMoves(moves);
+        if (count == 0) {
+            wdl[index] = position.inCheck() ? TBLoss : TBDraw;
+            if (wdl[index] == TBLoss) queue.push_back(index);
+            continue;
+        }
+
+        int inside = 0;
+        int best = TBLoss;
+        for (int i = 0; i < count; i++) {
+            if (!leavesTable(moves[i])) {
+                inside++;
+                continue;
+            }
+            ChessUndo undo;
+            position.makeMove(moves[i], undo);
+            TBValue child;
+            bool found = externalValue(tablebase, position, child);
+            position.unmakeMove(moves[i], undo);
+            if (!found) return false;
+            best = std::max(best, TBWin - child);
+        }
+
+        if (best == TBWin) {
+            wdl[index] = TBWin;
+            queue.push_back(index);
+        } else if (inside == 0) {
+            wdl[index] = (uint8_t)best;
+            if (best == TBLoss) queue.push_back(index);
+        } else {
+            remaining[index] = (uint8_t)inside;
+            fallback[index] = (uint8_t)best;
+        }
+    }
+
+    // -------------------------------
+    // backward pass: a move into a lost position wins, and a position whose
+    // every move inside the table wins for the opponent is lost unless a
+    // capture or promotion saves the draw
+    // -------------------------------
+    for (size_t next = 0; next < queue.size(); next++) {
+        uint64_t index = queue[next];
+        bool lost = wdl[index] == TBLoss;
+        int count = predecessors(index, layout, true, previous);
+        for (int i = 0; i < count; i++) {
+            uint64_t parent = previous[i];
+            if (wdl[parent] != kUnknown) continue;
+            if (lost) {
+                wdl[parent] = TBWin;
+                queue.push_back(parent);
+            } else if (--remaining[parent] == 0) {
+                wdl[parent] = fallback[parent];
+                if (fallback[parent] == TBLoss) queue.push_back(parent);
+            }
+        }
+    }
+    // whatever is still open can be held forever
+    for (uint8_t &value : wdl) {
+        if (value == kUnknown) value = TBDraw;
+    }
+    std::vector<uint64_t>().swap(queue);
+    std::vector<uint8_t>().swap(fallback);
+
+    // -------------------------------
+    // DTZ: zeroing moves and mates are the starting levels, then the same
+    // backward spread through piece moves only, one ply per level
+    // -------------------------------
+    std::vector<uint8_t> dtz(size, 0);
+    std::vector<uint8_t> done(size, 0);
+    std::vector<uint64_t> level, nextLevel;
+    std::vector<uint64_t> levelOne;
+
+    for (uint64_t index = 0; index < size; index++) {
+        if (wdl[index] != TBWin && wdl[index] != TBLoss) continue;
+        ChessTablebase::positionAt(index, layout, position);
+
+        BitMove moves[MAX_CHESS_MOVES];
+        int count = position.generateLegalMoves(moves);
+        if (count == 0) {
+            done[index] = 1;
+            level.push_back(index);     // mated, level 0
+            continue;
+        }
+
+        bool winningZero = false;
+        int pieceMoves = 0;
+        for (int i = 0; i < count; i++) {
+            bool zeroing = moves[i].isCapture() || moves[i].piece == Pawn;
+            if (!zeroing) {
+                pieceMoves++;
+                continue;
+            }
+            if (wdl[index] != TBWin || winningZero) continue;
+            ChessUndo undo;
+            position.makeMove(moves[i], undo);
+            TBValue child = TBInvalid;
+            bool found = true;
+            if (leavesTable(moves[i]))
+                found = externalValue(tablebase, position, child);
+            else
+                child = (TBValue)wdl[ChessTablebase::indexOf(position, layout, false)];
+            position.unmakeMove(moves[i], undo);
+            if (!found) return false;
+            winningZero = child == TBLoss;
+        }
+
+        if ((wdl[index] == TBWin && winningZero) || (wdl[index] == TBLoss && pieceMoves == 0)) {
+            done[index] = 1;
+            dtz[index] = 1;
+            levelOne.push_back(index);
+        } else if (wdl[index] == TBLoss) {
+            remaining[index] = (uint8_t)pieceMoves;
+        }
+    }
+
+    int distance = 0;
+    stats.longestDtz = 0;
+    while (!level.empty() || !levelOne.empty()) {
+        for (uint64_t index : level) {
+            bool lost = wdl[index] == TBLoss;
+            int count = predecessors(index, layout, false, previous);
+            for (int i = 0; i < count; i++) {
+                uint64_t parent = previous[i];
+                if (done[parent]) continue;
+                if (lost ? wdl[parent] != TBWin : (wdl[parent] != TBLoss || --remaining[parent] != 0)) continue;
+                done[parent] = 1;
+                dtz[parent] = (uint8_t)std::min(distance + 1, 255);
+                nextLevel.push_back(parent);
+            }
+        }
+        if (!level.empty()) stats.longestDtz = distance;
+        distance++;
+        level.swap(nextLevel);
+        nextLevel.clear();
+        // positions already settled at one ply join in at their level
+        if (distance == 1) {
+            level.insert(level.end(), levelOne.begin(), levelOne.end());
+            std::vector<uint64_t>().swap(levelOne);
+        }
+    }
+
+    uint64_t unresolved = 0;
+    for (uint64_t index = 0; index < size; index++) {
+        if ((wdl[index] == TBWin || wdl[index] == TBLoss) && !done[index]) unresolved++;
+    }
+    if (unresolved) printf("  warning: %llu decided positions without a DTZ\n", (unsigned long long)unresolved);
+
+    for (auto &side : stats.counts) side[0] = side[1] = 0;
+    for (uint64_t index = 0; index < size; index++) stats.counts[wdl[index]][index >> (6 * layout.count)]++;
+
+    if (!ChessTablebase::writeTable(directory, layout, false, wdl) ||
+        !ChessTablebase::writeTable(directory, layout, true, dtz)) {
+        printf("  cannot write %s\n", ChessTablebase::fileName(directory, signature, false).c_str());
+        return false;
+    }
+    return true;
+}
+
+// ===========================================================
+// Signatures to build
+// ===========================================================
+
+// every pawn and piece combination with this many pieces besides the kings, in canonical form
+static void signaturesWith(int extra, std::set<std::string> &out)
+{
+    static const char kPieces[] = "QRBNP";
+    // counts[i] = how many of kPieces[i] white has, then black
+    std::vector<std::string> sides[TablebaseLayout::MaxPieces];
+    for (int mask = 0; mask < 1 << (3 * 5); mask++) {
+        std::string side = "K";
+        int total = 0;
+        for (int i = 0; i < 5; i++) {
+            int n = (mask >> (3 * i)) & 7;
+            side.append(n, kPieces[i]);
+            total += n;
+        }
+        if (total < TablebaseLayout::MaxPieces) sides[total].push_back(side);
+    }
+
+    for (int white = 0; white <= extra; white++) {
+        for (const std::string &a : sides[white]) {
+            for (const std::string &b : sides[extra - white]) {
+                // build the position only to reuse the canonical ordering
+                ChessPosition position;
+                position.clear();
+                int square = 0;
+                for (int player = WHITE; player <= BLACK; player++) {
+                    for (char c : player == WHITE ? a : b) {
+                        ChessPiece piece = c == 'K' ? King : c == 'Q' ? Queen : c == 'R' ? Rook :
+                                           c == 'B' ? Bishop : c == 'N' ? Knight : Pawn;
+                        position.putPiece(player, piece, 8 + square++);
+                    }
+                }
+                bool flip;
+                out.insert(ChessTablebase::signatureOf(position, flip));
+            }
+        }
+    }
+}
+
+static int pawnCount(const std::string &signature)
+{
+    return (int)std::count(signature.begin(), signature.end(), 'P');
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        printf("usage: tbgen <directory> <max pieces, 3..%d>\n", TablebaseLayout::MaxPieces);
+        printf("       tbgen <directory> <signature> [signature...]\n");
+        return 1;
+    }
+    initChessAttacks();
+
+    std::string directory = argv[1];
+    std::vector<std::string> signatures;
+    int maxPieces = std::atoi(argv[2]);
+    if (maxPieces >= 3 && maxPieces <= TablebaseLayout::MaxPieces) {
+        std::set<std::string> all;
+        for (int extra = 1; extra <= maxPieces - 2; extra++) signaturesWith(extra, all);
+        signatures.assign(all.begin(), all.end());
+        // smaller tables first, and with the same count fewer pawns first, so
+        // captures and promotions always find their subtable already written
+        std::stable_sort(signatures.begin(), signatures.end(), [](const std::string &a, const std::string &b) {
+            if (a.size() != b.size()) return a.size() < b.size();
+            return pawnCount(a) < pawnCount(b);
+        });
+    } else {
+        for (int i = 2; i < argc; i++) signatures.push_back(argv[i]);
+    }
+
+    printf("%-10s %8s %10s %10s %10s %6s\n", "table", "time (s)", "wins", "draws", "losses", "dtz");
+    for (const std::string &signature : signatures) {
+        auto start = std::chrono::steady_clock::now();
+        GenerationStats stats;
+        if (!generateTable(directory, signature, stats)) {
+            printf("%s failed\n", signature.c_str());
+            return 1;
+        }
+        // white to move, the side written first
+        printf("%-10s %8.2f %10llu %10llu %10llu %6d\n", signature.c_str(), secondsSince(start),
+               (unsigned long long)stats.counts[TBWin][WHITE], (unsigned long long)stats.counts[TBDraw][WHITE],
+               (unsigned long long)stats.counts[TBLoss][WHITE], stats.longestDtz);
+    }
+    return 0;
+}
@@ -0,0 +1,339 @@
+// Headless UCI front-end for the chess engine, for tournament managers and batch testing.
+//
+// Supported: uci, isready, ucinewgame, setoption (Hash, Threads, EvalFile, UseNNUE, OwnBook, BookFile,
+// TablebasePath, TablebaseProbeDepth, TablebasePieces, Ponder), position fen/startpos moves,
+// go depth/movetime/nodes/wtime/btime/winc/binc/movestogo/infinite/ponder, ponderhit, stop, quit.
+//
+// Like perft, only the chess rules and search code is linked. The search runs on its own
+// thread so stop and quit are read while it thinks.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "classes/ChessAttacks.h"
+#include "classes/ChessBook.h"
+#include "classes/ChessNNUE.h"
+#include "classes/ChessPosition.h"
+#include "classes/ChessSearch.h"
+#include "classes/ChessTablebase.h"
+#include "classes/ChessTT.h"
+
+static const char *kEngineName   = "GameFramework Chess";
+static const char *kEngineAuthor = "GameFramework";
+
+// network loaded at startup if it is there, UseNNUE picks it over the hand-written evaluation
+static const char *kDefaultEvalFile = "chess.nnue";
+
+// Polyglot book, opened when OwnBook is switched on
+static const char *kDefaultBookFile = "book.bin";
+
+// endgame tables written by tbgen, off until TablebasePath names their directory
+static const int kDefaultTablebaseProbeDepth = 1;
+
+// time kept back for GUI and pipe latency on every move
+static const int64_t kMoveOverheadMs = 30;
+
+// the search thread and the command loop both write to stdout
+static std::mutex gOutputMutex;
+
+static void send(const std::string &line)
+{
+    std::lock_guard<std::mutex> lock(gOutputMutex);
+    std::cout << line << std::endl;
+}
+
+// ===========================================================
+// Engine state
+// ===========================================================
+
+struct UciEngine
+{
+    TranspositionTable tt;
+    ChessSearch        search;
+    ChessPosition      position;
+    std::vector<uint64_t> history;  // keys of the game's positions before this one, for repetitions
+    ChessNetwork       network;
+    bool               useNetwork;
+    ChessBook          book;
+    bool               useBook;
+    std::string        bookFile;
+    ChessTablebase     tablebase;
+    int                tbProbeDepth;
+    int                tbPieceLimit;
+
+    std::thread        searchThread;
+    std::atomic<bool>  stopRequested;   // stop or quit seen, an infinite search may report
+    bool               infinite;
+    std::atomic<bool>  pondering;       // "go ponder" not yet followed by ponderhit
+
+    UciEngine()
+        : tt(16), search(tt), useNetwork(false), useBook(false), bookFile(kDefaultBookFile),
+          tbProbeDepth(kDefaultTablebaseProbeDepth), tbPieceLimit(TablebaseLayout::DefaultPieces),
+          stopRequested(false), infinite(false), pondering(false)
+    {
+        position.setFEN(ChessPosition::StartFEN);
+        search.setReporter([](const SearchReport &report) { send(formatReport(report)); });
+        std::string error;
+        network.load(kDefaultEvalFile, error);
+    }
+
+    // only called between searches
+    void selectEvaluation()
+    {
+        search.setNetwork(useNetwork && network.loaded() ? &network : nullptr);
+    }
+
+    void openBook()
+    {
+        book.close();
+        if (!useBook) return;
+        std::string error;
+        if (book.open(bookFile, error))
+            send("info string book " + bookFile + ", " + std::to_string(book.size()) + " entries");
+        else
+            send("info string no book: " + error);
+    }
+
+    // only called between searches
+    void selectTablebase()
+    {
+        search.setTablebase(tablebase.enabled() ? &tablebase : nullptr, tbProbeDepth, tbPieceLimit);
+    }
+
+    void stopSearch()
+    {
+        stopRequested.store(true);
+        search.stop();
+        if (searchThread.joinable()) searchThread.join();
+    }
+};
+
+// find the legal move with this UCI spelling, returns false if there is none
+static bool parseMove(const ChessPosition &position, const std::string &text, BitMove &move)
+{
+    BitMove moves[MAX_CHESS_MOVES];
+    int count = position.generateLegalMoves(moves);
+    for (int i = 0; i < count; i++) {
+        if (moveToString(moves[i]) != text) continue;
+        move = moves[i];
+        return true;
+    }
+    return false;
+}
+
+// ===========================================================
+// Commands
+// ===========================================================
+
+static void cmdUci()
+{
+    send(std::string("id name ") + kEngineName);
+    send(std::string("id author ") + kEngineAuthor);
+    send("option name Hash type spin default 16 min 1 max 4096");
+    send("option name Threads type spin default 1 min 1 max 64");
+    send(std::string("option name EvalFile type string default ") + kDefaultEvalFile);
+    send("option name UseNNUE type check default false");
+    send("option name OwnBook type check default false");
+    send(std::string("option name BookFile type string default ") + kDefaultBookFile);
+    send("option name Ponder type check default false");
+    send("option name TablebasePath type string default <empty>");
+    send("option name TablebaseProbeDepth type spin default " + std::to_string(kDefaultTablebaseProbeDepth) +
+         " min 1 max 100");
+    send("option name TablebasePieces type spin default " + std::to_string(TablebaseLayout::DefaultPieces) +
+         " min 0 max " + std::to_string(TablebaseLayout::MaxPieces));
+    send("uciok");
+}
+
+// setoption name <id> value <x>
+static void cmdSetOption(UciEngine &engine, std::istringstream &in)
+{
+    std::string token, name, value;
+    in >> token;   // "name"
+    while (in >> token && token != "value") name += (name.empty() ? "" : " ") + token;
+    // the rest of the line, file names may have spaces
+    std::getline(in >> std::ws, value);
+
+    if (name == "Hash") {
+        engine.tt.resize((size_t)std::max(1, std::atoi(value.c_str())));
+    } else if (name == "Threads") {
+        engine.search.setThreads(std::max(1, std::atoi(value.c_str())));
+    } else if (name == "EvalFile") {
+        std::string error;
+        if (engine.network.load(value, error))
+            send("info string loaded network " + value + " (" + ChessNetwork::kernelName(ChessNetwork::kernel()) +
+                 ")");
+        else
+            send("info string " + error);
+        engine.selectEvaluation();
+    } else if (name == "UseNNUE") {
+        engine.useNetwork = value == "true";
+        if (engine.useNetwork && !engine.network.loaded()) send("info string no network loaded, set EvalFile");
+        engine.selectEvaluation();
+    } else if (name == "OwnBook") {
+        engine.useBook = value == "true";
+        engine.openBook();
+    } else if (name == "BookFile") {
+        engine.bookFile = value;
+        engine.openBook();
+    } else if (name == "Ponder") {
+        // only tells us the GUI may send go ponder, nothing to set up
+    } else if (name == "TablebasePath") {
+        engine.tablebase.setPath(value == "<empty>" ? "" : value);
+        engine.selectTablebase();
+    } else if (name == "TablebaseProbeDepth") {
+        engine.tbProbeDepth = std::max(1, std::atoi(value.c_str()));
+        engine.selectTablebase();
+    } else if (name == "TablebasePieces") {
+        engine.tbPieceLimit = std::max(0, std::atoi(value.c_str()));
+        engine.selectTablebase();
+    } else {
+        send("info string unknown option " + name);
+    }
+}
+
+// position [startpos | fen <fen>] [moves <move> ...]
+static void cmdPosition(UciEngine &engine, std::istringstream &in)
+{
+    std::string token, fen;
+    in >> token;
+    if (token == "startpos") {
+        fen = ChessPosition::StartFEN;
+        in >> token;   // "moves", if any
+    } else if (token == "fen") {
+        while (in >> token && token != "moves") fen += (fen.empty() ? "" : " ") + token;
+    } else {
+        return;
+    }
+
+    ChessPosition position;
+    if (!position.setFEN(fen)) {
+        send("info string bad fen " + fen);
+        return;
+    }
+
+    std::vector<uint64_t> history;
+    while (in >> token) {
+        BitMove move;
+        if (!parseMove(position, token, move)) {
+            send("info string illegal move " + token);
+            break;
+        }
+        ChessUndo undo;
+        history.push_back(position.key());
+        position.makeMove(move, undo);
+    }
+    engine.position = position;
+    engine.history = history;
+}
+
+static void cmdGo(UciEngine &engine, std::istringstream &in)
+{
+    engine.stopSearch();
+
+    SearchLimits limits;
+    int64_t time[2] = { 0, 0 }, increment[2] = { 0, 0 };
+    int64_t moveTime = 0;
+    int movesToGo = 0;
+    bool infinite = false;
+    bool ponder = false;
+
+    std::string token;
+    while (in >> token) {
+        if (token == "depth")          in >> limits.maxDepth;
+        else if (token == "nodes")     in >> limits.maxNodes;
+        else if (token == "movetime")  in >> moveTime;
+        else if (token == "wtime")     in >> time[WHITE];
+        else if (token == "btime")     in >> time[BLACK];
+        else if (token == "winc")      in >> increment[WHITE];
+        else if (token == "binc")      in >> increment[BLACK];
+        else if (token == "movestogo") in >> movesToGo;
+        else if (token == "infinite")  infinite = true;
+        else if (token == "ponder")    ponder = true;
+    }
+
+    int us = engine.position.sideToMove();
+    if (moveTime > 0) {
+        limits.softTimeMs = limits.hardTimeMs = std::max<int64_t>(1, moveTime - kMoveOverheadMs);
+    } else if (time[us] > 0) {
+        // spread the clock over the moves left, with a hard cap well short of flagging
+        int64_t left = std::max<int64_t>(1, time[us] - kMoveOverheadMs);
+        int64_t share = left / (movesToGo > 0 ? movesToGo : 30) + increment[us] * 3 / 4;
+        limits.softTimeMs = std::max<int64_t>(1, std::min(share, left / 2));
+        limits.hardTimeMs = std::max<int64_t>(1, std::min(share * 4, left / 2));
+    }
+    if (infinite) limits = SearchLimits();
+
+    // a book move is answered at once, analysis and pondering always search
+    BitMove bookMove;
+    if (!infinite && !ponder && engine.book.isOpen() && engine.book.probe(engine.position, bookMove)) {
+        send("info string book move");
+        send("bestmove " + moveToString(bookMove));
+        return;
+    }
+
+    engine.stopRequested.store(false);
+    engine.infinite = infinite;
+    // the position already holds the move being pondered on, the limits are for after the hit
+    engine.pondering.store(ponder);
+    // armed here rather than on the search thread, a stop or ponderhit read before it starts still counts
+    engine.search.prepare(ponder);
+    ChessPosition root = engine.position;
+    std::vector<uint64_t> history = engine.history;
+    engine.searchThread = std::thread([&engine, root, history, limits]() {
+        BitMove best = engine.search.search(root, limits, history);
+        // "go infinite" and "go ponder" must not answer before they are told to stop or hit
+        while ((engine.infinite || engine.pondering.load()) && !engine.stopRequested.load())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (best.from == best.to) {
+            send("bestmove 0000");
+            return;
+        }
+        // the reply the search expects is what the GUI lets us ponder on
+        const std::vector<BitMove> &pv = engine.search.lastReport().pv;
+        std::string reply = pv.size() > 1 && pv[0] == best ? " ponder " + moveToString(pv[1]) : "";
+        send("bestmove " + moveToString(best) + reply);
+    });
+}
+
+// the opponent played the move we were pondering on: the search carries on under its limits
+static void cmdPonderHit(UciEngine &engine)
+{
+    if (!engine.pondering.exchange(false)) return;
+    engine.search.ponderHit();
+}
+
+int main(int argc, char **argv)
+{
+    std::ios::sync_with_stdio(false);
+    initChessAttacks();
+
+    UciEngine engine;
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream in(line);
+        std::string command;
+        in >> command;
+
+        if (command == "uci")               cmdUci();
+        else if (command == "isready")      send("readyok");
+        else if (command == "ucinewgame")   { engine.stopSearch(); engine.tt.clear(); }
+        else if (command == "setoption")    { engine.stopSearch(); cmdSetOption(engine, in); }
+        else if (command == "position")     { engine.stopSearch(); cmdPosition(engine, in); }
+        else if (command == "go")           cmdGo(engine, in);
+        else if (command == "ponderhit")    cmdPonderHit(engine);
+        else if (command == "stop")         engine.stopSearch();
+        else if (command == "quit")         break;
+        else if (!command.empty())          send("info string unknown command " + command);
+    }
+
+    engine.stopSearch();
+    return 0;
+}